@@ -70,11 +70,18 @@ struct channel
     struct lock lock;           /* Must acquire to access the controller. */
     bool expecting_interrupt;   /* True if an interrupt is expected, false if
                                    any interrupt would be spurious. */
-    struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+    struct semaphore completion_wait;   /* Up'd by completion_softirq. */
+    struct softirq completion_softirq;  /* Raised by interrupt handler. */
+    struct timer completion_timer;      /* Fires if no interrupt arrives. */
+    bool timed_out;             /* Did completion_timer up the semaphore? */
 
     struct ata_disk devices[2];     /* The devices on this channel. */
   };
 
+/* Time to wait for a command completion interrupt before giving
+   up.  The ATA standards allow a disk up to 30 seconds. */
+#define COMPLETION_TIMEOUT (30 * TIMER_FREQ)
+
 /* We support the two "legacy" ATA channels found in a standard PC. */
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
@@ -95,6 +102,9 @@ static bool wait_while_busy (const struct ata_disk *);
 static void select_device (const struct ata_disk *);
 static void select_device_wait (const struct ata_disk *);
 
+static bool wait_for_completion (struct channel *);
+static void completion_timeout (void *channel_);
+static void complete (void *channel_);
 static void interrupt_handler (struct intr_frame *);
 
 /* Initialize the disk subsystem and detect disks. */
@@ -126,6 +136,8 @@ ide_init (void)
       lock_init (&c->lock);
       c->expecting_interrupt = false;
       sema_init (&c->completion_wait, 0);
+      softirq_init (&c->completion_softirq, complete, c);
+      c->completion_timer.pending = false;
  
       /* Initialize devices. */
       for (dev_no = 0; dev_no < 2; dev_no++)
@@ -273,8 +285,7 @@ identify_ata_device (struct ata_disk *d)
      into our buffer. */
   select_device_wait (d);
   issue_pio_command (c, CMD_IDENTIFY_DEVICE);
-  sema_down (&c->completion_wait);
-  if (!wait_while_busy (d))
+  if (!wait_for_completion (c) || !wait_while_busy (d))
     {
       d->is_ata = false;
       return;
@@ -349,8 +360,7 @@ ide_read (void *d_, block_sector_t sec_no, void *buffer)
   lock_acquire (&c->lock);
   select_sector (d, sec_no);
   issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-  sema_down (&c->completion_wait);
-  if (!wait_while_busy (d))
+  if (!wait_for_completion (c) || !wait_while_busy (d))
     PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
   input_sector (c, buffer);
   lock_release (&c->lock);
@@ -372,7 +382,8 @@ ide_write (void *d_, block_sector_t sec_no, const void *buffer)
   if (!wait_while_busy (d))
     PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
   output_sector (c, buffer);
-  sema_down (&c->completion_wait);
+  if (!wait_for_completion (c))
+    PANIC ("%s: disk write timed out, sector=%"PRDSNu, d->name, sec_no);
   lock_release (&c->lock);
 }
 
@@ -502,7 +513,47 @@ select_device_wait (const struct ata_disk *d)
   wait_until_idle (d);
 }
 
-/* ATA interrupt handler. */
+/* Waits for the completion interrupt of the command just issued
+   on channel C.  Returns true if it arrived, false if
+   COMPLETION_TIMEOUT ticks passed first. */
+static bool
+wait_for_completion (struct channel *c) 
+{
+  c->timed_out = false;
+  timer_add (&c->completion_timer, timer_ticks () + COMPLETION_TIMEOUT,
+             completion_timeout, c);
+  sema_down (&c->completion_wait);
+  timer_cancel (&c->completion_timer);
+  return !c->timed_out;
+}
+
+/* Timer callback that wakes up a waiter on CHANNEL_ whose
+   completion interrupt never arrived. */
+static void
+completion_timeout (void *channel_) 
+{
+  struct channel *c = channel_;
+
+  if (c->expecting_interrupt) 
+    {
+      c->expecting_interrupt = false;
+      c->timed_out = true;
+      sema_up (&c->completion_wait);
+    }
+}
+
+/* Softirq raised by the interrupt handler: wakes up the waiter
+   on CHANNEL_. */
+static void
+complete (void *channel_) 
+{
+  struct channel *c = channel_;
+
+  sema_up (&c->completion_wait);
+}
+
+/* ATA interrupt handler.  Acknowledges the interrupt and leaves
+   waking up the waiter to complete(). */
 static void
 interrupt_handler (struct intr_frame *f) 
 {
@@ -514,7 +565,8 @@ interrupt_handler (struct intr_frame *f)
         if (c->expecting_interrupt) 
           {
             inb (reg_status (c));               /* Acknowledge interrupt. */
-            sema_up (&c->completion_wait);      /* Wake up waiter. */
+            c->expecting_interrupt = false;
+            softirq_raise (&c->completion_softirq); /* Wake up waiter. */
           }
         else
           printf ("%s: unexpected interrupt\n", c->name);
@@ -1,6 +1,7 @@
 #include "devices/intq.h"
 #include <debug.h>
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 static int next (int pos);
 static void wait (struct intq *q, struct thread **waiter);
@@ -92,6 +93,7 @@ wait (struct intq *q UNUSED, struct thread **waiter)
           || (waiter == &q->not_full && intq_full (q)));
 
   *waiter = thread_current ();
+  TRACE (TRACE_BLOCK, (*waiter)->tid, 0, TRACE_REASON_OTHER);
   thread_block ();
 }
 
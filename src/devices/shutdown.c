@@ -4,8 +4,13 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/lockstat.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
@@ -90,6 +95,8 @@ shutdown_power_off (void)
   const char s[] = "Shutdown";
   const char *p;
 
+  trace_dump ();
+
 #ifdef FILESYS
   filesys_done ();
 #endif
@@ -129,7 +136,13 @@ static void
 print_stats (void)
 {
   timer_print_stats ();
+  intr_print_stats ();
   thread_print_stats ();
+  palloc_print_stats ();
+  kmem_print_stats ();
+#ifdef LOCKSTAT
+  lockstat_print_stats ();
+#endif
 #ifdef FILESYS
   block_print_stats ();
 #endif
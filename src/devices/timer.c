@@ -7,6 +7,7 @@
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,7 +25,102 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* TSC clocksource, set up by timer_calibrate().  timer_now_ns()
+   is TSC_BASE_NS plus the TSC cycles since TSC_BASE converted to
+   nanoseconds as (cycles * TSC_MULT) >> TSC_SHIFT.  Until then,
+   TSC_MULT is 0 and timer_now_ns() counts whole ticks. */
+#define TSC_SHIFT 24
+static uint64_t tsc_base;
+static int64_t tsc_base_ns;
+static uint64_t tsc_mult;
+
+/* Number of ticks over which the TSC is calibrated. */
+#define TSC_CALIBRATE_TICKS (TIMER_FREQ / 10)
+
+/* Hierarchical timing wheel holding pending kernel timers.
+
+   Level 0 has one slot per tick for the next WHEEL_SIZE ticks.
+   Each slot of level L covers WHEEL_SIZE^L ticks.  A timer is
+   placed at the lowest level whose range covers its delay,
+   indexed by the corresponding bits of its expiry tick.  When
+   the level 0 index wraps around to zero, the current slot of
+   level 1 is emptied and its timers are reinserted, landing in
+   level 0; level 2 cascades into level 1 in the same way, and so
+   on.  Adding and cancelling a timer is O(1), and each timer is
+   cascaded at most WHEEL_LEVELS - 1 times before it expires, so
+   the work per tick does not depend on how many timers are
+   pending. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+
+/* Next tick whose level 0 slot has not yet been run. */
+static int64_t wheel_next;
+
+/* Timers taken off the wheel whose callbacks have not run yet. */
+static struct list wheel_expired;
+
+/* Runs the wheel up to the current tick after each timer
+   interrupt.  Each run does at most WHEEL_RUN_BUDGET units of
+   work, counting one per tick advanced and one per callback, and
+   raises the softirq again if it leaves work behind, so that a
+   long tickless idle or a burst of expiring timers cannot keep
+   one softirq running for long. */
+#define WHEEL_RUN_BUDGET 32
+static struct softirq timer_softirq;
+
+/* If true, the idle thread stops the periodic tick while nothing
+   is due.  Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* PIT cycles in one timer tick, as programmed by timer_init(). */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* While the idle thread has the PIT in one-shot mode,
+   oneshot_periods is the number of ticks the one-shot stands in
+   for, the first of which ends oneshot_first cycles after it was
+   armed and the last oneshot_count cycles after.  Zero while the
+   PIT is periodic. */
+static int oneshot_periods;
+static unsigned oneshot_first;
+static unsigned oneshot_count;
+
+/* A thread in a sub-tick sleep. */
+struct hr_sleeper 
+  {
+    int64_t deadline;           /* timer_now_ns() at which to wake. */
+    struct thread *thread;      /* Sleeping thread. */
+    struct list_elem elem;      /* Element in hr_sleepers. */
+  };
+
+/* Threads in sub-tick sleeps, soonest deadline first.  When the
+   first is due before the next tick, the PIT is switched to a
+   one-shot that fires at its deadline, and HR_REST holds the PIT
+   cycles left from there to the tick boundary.  HR_REST is 0
+   while no such one-shot is armed. */
+static struct list hr_sleepers;
+static unsigned hr_rest;
+
+/* Sleeps shorter than this busy-wait, because blocking and
+   being woken by an interrupt would take about as long. */
+#define HR_SLEEP_MIN_NS 20000
+
 static intr_handler_func timer_interrupt;
+static void timer_tick_once (struct intr_frame *);
+static int ticks_until_next_event (int max);
+static void wheel_insert (struct timer *);
+static void wheel_advance (void);
+static void wheel_run (void *aux);
+static void wake_sleeper (void *thread_);
+static void hr_sleep (int64_t ns);
+static void hr_program (void);
+static void hr_expire (void);
+static unsigned hr_cycles_until (int64_t deadline);
+static bool hr_sleeper_less (const struct list_elem *,
+                             const struct list_elem *, void *aux);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -35,15 +131,28 @@ static void real_time_delay (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
+  int level, slot;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SIZE; slot++)
+      list_init (&wheel[level][slot]);
+  list_init (&wheel_expired);
+  wheel_next = ticks + 1;
+  softirq_init (&timer_softirq, wheel_run, NULL);
+  list_init (&hr_sleepers);
+
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays,
+   and the TSC clocksource behind timer_now_ns(). */
 void
 timer_calibrate (void) 
 {
   unsigned high_bit, test_bit;
+  uint64_t tsc_hz;
+  int64_t start;
 
   ASSERT (intr_get_level () == INTR_ON);
   printf ("Calibrating timer...  ");
@@ -63,7 +172,24 @@ timer_calibrate (void)
     if (!too_many_loops (high_bit | test_bit))
       loops_per_tick |= test_bit;
 
-  printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+  /* Count TSC cycles between two tick edges. */
+  start = ticks;
+  while (ticks == start)
+    barrier ();
+  start = ticks;
+  tsc_base = timer_cycles ();
+  while (ticks < start + TSC_CALIBRATE_TICKS)
+    barrier ();
+  tsc_hz = (timer_cycles () - tsc_base) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+
+  /* Switch timer_now_ns() over without going backward. */
+  intr_disable ();
+  tsc_base_ns = start * NSEC_PER_TICK;
+  tsc_mult = ((uint64_t) NSEC_PER_SEC << TSC_SHIFT) / tsc_hz;
+  intr_enable ();
+
+  printf ("%'"PRIu64" loops/s, %'"PRIu64" kHz TSC.\n",
+          (uint64_t) loops_per_tick * TIMER_FREQ, tsc_hz / 1000);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -84,22 +210,113 @@ timer_elapsed (int64_t then)
   return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted, with
+   the resolution of the CPU's time-stamp counter once
+   timer_calibrate() has run. */
+int64_t
+timer_now_ns (void) 
+{
+  if (tsc_mult == 0)
+    return timer_ticks () * NSEC_PER_TICK;
+  return tsc_base_ns + timer_cycles_to_ns (timer_cycles () - tsc_base);
+}
+
+/* Returns the CPU's time-stamp counter. */
+uint64_t
+timer_cycles (void) 
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Converts CYCLES of the time-stamp counter to nanoseconds.
+   Returns 0 until timer_calibrate() has run. */
+int64_t
+timer_cycles_to_ns (uint64_t cycles) 
+{
+  /* Multiply in two halves so that the product cannot overflow. */
+  return ((((cycles >> 32) * tsc_mult) << (32 - TSC_SHIFT))
+          + (((cycles & 0xffffffff) * tsc_mult) >> TSC_SHIFT));
+}
+
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void
 timer_sleep (int64_t ticks) 
 {
-  // int64_t start = timer_ticks ();
+  struct timer alarm;
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  // while (timer_elapsed (start) < ticks) 
-  //   thread_yield ();
 
   if (ticks > 0) 
-  {
-	 // printf("Sleep %d ticks.\n", ticks);
-   thread_sleep_until(timer_ticks () + ticks);   
-  }
+    {
+      alarm.pending = false;
+      old_level = intr_disable ();
+      timer_add (&alarm, timer_ticks () + ticks, wake_sleeper,
+                 thread_current ());
+      TRACE (TRACE_BLOCK, thread_current ()->tid, 0, TRACE_REASON_SLEEP);
+      thread_block ();
+      intr_set_level (old_level);
+    }
+}
+
+/* Timer callback for timer_sleep(): wakes up THREAD_, preempting
+   the running thread if the sleeper outranks it. */
+static void
+wake_sleeper (void *thread_) 
+{
+  struct thread *t = thread_;
+
+  thread_unblock (t);
+  if (thread_preempts (t))
+    intr_yield_on_return ();
+}
+
+/* Arranges for FUNC to be called with AUX from the timer
+   interrupt at timer tick EXPIRES, or at the next tick if
+   EXPIRES has already passed.  TIMER must not already be
+   pending; a new timer should have its `pending' member set to
+   false (zeroing it will do). */
+void
+timer_add (struct timer *timer, int64_t expires, timer_func *func, void *aux) 
+{
+  enum intr_level old_level;
+
+  ASSERT (timer != NULL);
+  ASSERT (func != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (!timer->pending);
+  timer->expires = expires;
+  timer->func = func;
+  timer->aux = aux;
+  timer->pending = true;
+  wheel_insert (timer);
+  intr_set_level (old_level);
+}
+
+/* Cancels TIMER.  Returns true if it was still pending, false if
+   it had already expired or was never added. */
+bool
+timer_cancel (struct timer *timer) 
+{
+  enum intr_level old_level;
+  bool was_pending;
+
+  ASSERT (timer != NULL);
+
+  old_level = intr_disable ();
+  was_pending = timer->pending;
+  if (was_pending)
+    {
+      list_remove (&timer->elem);
+      timer->pending = false;
+    }
+  intr_set_level (old_level);
+
+  return was_pending;
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -172,25 +389,356 @@ timer_print_stats (void)
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, replaces the periodic tick by a
+   single PIT interrupt at the next tick on which a timer
+   expires or the wheel cascades, as far out as the 16-bit PIT
+   counter allows.  The one-shot is aligned to the periodic tick
+   boundaries, so no time is lost. */
+void
+timer_idle_enter (void) 
+{
+  unsigned first;
+  bool output;
+  int periods;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_periods != 0 || !list_empty (&hr_sleepers)
+      || softirq_pending ())
+    return;
+
+  first = pit_read_count (0, &output);
+  if (first == 0 || first > TICK_CYCLES)
+    return;
+  periods = ticks_until_next_event (1 + (UINT16_MAX - first) / TICK_CYCLES);
+  if (periods < 2)
+    return;
+
+  oneshot_periods = periods;
+  oneshot_first = first;
+  oneshot_count = first + (periods - 1) * TICK_CYCLES;
+  pit_configure_oneshot (0, oneshot_count);
+}
+
+/* Called at the start of every external interrupt.  If the idle
+   thread armed a one-shot that has not fired yet, accounts for
+   the ticks that have passed since then and shortens the
+   one-shot to end at the next tick boundary, after which
+   timer_interrupt() restores the periodic tick.  Thus a thread
+   woken by this interrupt sees an exact timer_ticks() and gets
+   periodic time slices again within one tick. */
+void
+timer_idle_exit (void) 
+{
+  unsigned elapsed, remaining;
+  bool expired;
+  int crossed;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (oneshot_periods == 0)
+    return;
+
+  elapsed = oneshot_count - pit_read_count (0, &expired);
+  if (expired)
+    return;
+
+  crossed = (elapsed < oneshot_first ? 0
+             : 1 + (elapsed - oneshot_first) / TICK_CYCLES);
+  if (crossed > oneshot_periods - 1)
+    crossed = oneshot_periods - 1;
+  remaining = oneshot_first + crossed * TICK_CYCLES - elapsed;
+  if (remaining == 0)
+    remaining = 1;
+
+  oneshot_periods = 1;
+  oneshot_first = oneshot_count = remaining;
+  pit_configure_oneshot (0, remaining);
+
+  while (crossed-- > 0)
+    timer_tick_once (NULL);
+}
+
+/* Returns the number of ticks, at least 1 and at most MAX, until
+   the next tick on which the wheel has work to do. */
+static int
+ticks_until_next_event (int max) 
+{
+  int k;
+
+  for (k = 1; k < max; k++)
+    {
+      int64_t t = wheel_next + k - 1;
+      if ((t & WHEEL_MASK) == 0 || !list_empty (&wheel[0][t & WHEEL_MASK]))
+        break;
+    }
+  return k;
+}
+
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED)
+timer_interrupt (struct intr_frame *args)
+{
+  if (hr_rest != 0) 
+    {
+      bool expired;
+
+      /* As below, a low PIT output means a periodic tick that
+         was pending when hr_program() armed the one-shot. */
+      pit_read_count (0, &expired);
+      if (expired) 
+        {
+          hr_expire ();
+          return;
+        }
+    }
+  else if (oneshot_periods != 0) 
+    {
+      bool expired;
+
+      /* If the PIT output is still low, this is a periodic tick
+         that was already pending when the one-shot was armed,
+         and timer_idle_exit() has just rearmed the one-shot. */
+      pit_read_count (0, &expired);
+      if (expired) 
+        {
+          for (; oneshot_periods > 1; oneshot_periods--)
+            timer_tick_once (NULL);
+          oneshot_periods = 0;
+          pit_configure_channel (0, 2, TIMER_FREQ);
+        }
+    }
+
+  timer_tick_once (args);
+}
+
+/* Does the work of one timer tick.  F is the frame of the code
+   that the timer interrupted, or a null pointer for a tick that
+   passed while the CPU was halted. */
+static void
+timer_tick_once (struct intr_frame *f) 
 {
   ticks++;
 
-  // Lily
-  thread_tick (timer_ticks());
-  
-  // // add
-  // if (thread_mlfqs)
-  // {
-  //   thread_mlfqs_increase_recent_cpu ();
-  //   if (ticks % TIMER_FREQ == 0)
-  //     thread_mlfqs_update_load_avg_and_recent_cpu ();
-  //   else if (ticks % 4 == 0)
-  //     thread_mlfqs_update_priority (thread_current ());
-  // }
+  thread_tick (f);
+  softirq_raise (&timer_softirq);
+
+  if (thread_mlfqs)
+    {
+      thread_mlfqs_increase_recent_cpu ();
+      if (ticks % TIMER_FREQ == 0)
+        thread_mlfqs_update_load_avg_and_recent_cpu ();
+      else if (ticks % 4 == 0)
+        thread_mlfqs_update_priority (thread_current ());
+    }
+
+  hr_program ();
+}
+
+/* Blocks the running thread for NS nanoseconds, which should be
+   less than a tick, using a one-shot PIT interrupt to wake it
+   rather than the next tick. */
+static void
+hr_sleep (int64_t ns) 
+{
+  struct hr_sleeper s;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  s.deadline = timer_now_ns () + ns;
+  s.thread = thread_current ();
+  list_insert_ordered (&hr_sleepers, &s.elem, hr_sleeper_less, NULL);
+  hr_program ();
+  TRACE (TRACE_BLOCK, s.thread->tid, 0, TRACE_REASON_SLEEP);
+  thread_block ();
+  intr_set_level (old_level);
+}
+
+/* If the first sub-tick sleeper is due before the PIT's next
+   interrupt, rearms the PIT as a one-shot for its deadline.
+   Does nothing while the idle thread's one-shot is in use;
+   the sleeper is then picked up at the following tick. */
+static void
+hr_program (void) 
+{
+  struct hr_sleeper *s;
+  unsigned remaining, count;
+  bool expired;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (list_empty (&hr_sleepers) || oneshot_periods != 0)
+    return;
+
+  remaining = pit_read_count (0, &expired);
+  if (hr_rest != 0 && expired)
+    return;
+
+  s = list_entry (list_front (&hr_sleepers), struct hr_sleeper, elem);
+  count = hr_cycles_until (s->deadline);
+  if (count < remaining)
+    {
+      hr_rest += remaining - count;
+      pit_configure_oneshot (0, count);
+    }
+}
+
+/* Handles expiry of the one-shot armed by hr_program(): wakes
+   the sleepers that are due, then arms a one-shot for the next
+   sleeper or, failing that, for the rest of the tick, after
+   which timer_interrupt() restores the periodic tick. */
+static void
+hr_expire (void) 
+{
+  unsigned rest = hr_rest;
+  unsigned count = rest;
+  int64_t now = timer_now_ns ();
+
+  while (!list_empty (&hr_sleepers)) 
+    {
+      struct hr_sleeper *s = list_entry (list_front (&hr_sleepers),
+                                         struct hr_sleeper, elem);
+      if (s->deadline > now)
+        {
+          count = hr_cycles_until (s->deadline);
+          break;
+        }
+      list_pop_front (&hr_sleepers);
+      wake_sleeper (s->thread);
+    }
+
+  if (count < rest) 
+    {
+      hr_rest = rest - count;
+      pit_configure_oneshot (0, count);
+    }
+  else
+    {
+      hr_rest = 0;
+      oneshot_periods = 1;
+      oneshot_first = oneshot_count = rest;
+      pit_configure_oneshot (0, rest);
+    }
+}
+
+/* Returns the number of PIT cycles from now until DEADLINE, a
+   timer_now_ns() value, rounded up to at least 1 and capped at
+   one tick. */
+static unsigned
+hr_cycles_until (int64_t deadline) 
+{
+  int64_t ns = deadline - timer_now_ns ();
 
+  if (ns <= 0)
+    return 1;
+  if (ns >= NSEC_PER_TICK)
+    return TICK_CYCLES;
+  return DIV_ROUND_UP (ns * PIT_HZ, NSEC_PER_SEC);
+}
+
+/* Orders hr_sleepers by deadline. */
+static bool
+hr_sleeper_less (const struct list_elem *a_, const struct list_elem *b_,
+                 void *aux UNUSED) 
+{
+  const struct hr_sleeper *a = list_entry (a_, struct hr_sleeper, elem);
+  const struct hr_sleeper *b = list_entry (b_, struct hr_sleeper, elem);
+
+  return a->deadline < b->deadline;
+}
+
+/* Puts pending TIMER into the wheel slot for its expiry tick. */
+static void
+wheel_insert (struct timer *timer) 
+{
+  int64_t expires = timer->expires;
+  int64_t delta;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (expires < wheel_next)
+    expires = wheel_next;
+  delta = expires - wheel_next;
+  if (delta >= WHEEL_RANGE)
+    {
+      /* Too far out for the wheel.  Park the timer in the last
+         slot it can reach; it is reinserted on each cascade
+         until it comes into range. */
+      delta = WHEEL_RANGE - 1;
+      expires = wheel_next + delta;
+    }
+
+  for (level = 0; delta >= ((int64_t) WHEEL_SIZE << (level * WHEEL_BITS));
+       level++)
+    continue;
+  list_push_back (&wheel[level][(expires >> (level * WHEEL_BITS)) & WHEEL_MASK],
+                  &timer->elem);
+}
+
+/* Timer softirq: runs the wheel toward the current tick, within
+   WHEEL_RUN_BUDGET. */
+static void
+wheel_run (void *aux UNUSED) 
+{
+  enum intr_level old_level = intr_disable ();
+  int budget;
+
+  for (budget = WHEEL_RUN_BUDGET; budget > 0; budget--)
+    if (!list_empty (&wheel_expired))
+      {
+        struct timer *timer = list_entry (list_pop_front (&wheel_expired),
+                                          struct timer, elem);
+        timer->pending = false;
+        timer->func (timer->aux);
+
+        /* Let interrupts in between callbacks. */
+        intr_enable ();
+        intr_disable ();
+      }
+    else if (wheel_next <= ticks)
+      wheel_advance ();
+    else
+      break;
+
+  if (!list_empty (&wheel_expired) || wheel_next <= ticks)
+    softirq_raise (&timer_softirq);
+  intr_set_level (old_level);
+}
+
+/* Moves the timers that expire at tick wheel_next to
+   wheel_expired, first cascading higher levels of the wheel into
+   lower ones as their indexes wrap, and then advances
+   wheel_next. */
+static void
+wheel_advance (void) 
+{
+  int64_t now = wheel_next;
+  struct list *slot;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+      if (((now >> ((level - 1) * WHEEL_BITS)) & WHEEL_MASK) != 0)
+        break;
+
+      slot = &wheel[level][(now >> (level * WHEEL_BITS)) & WHEEL_MASK];
+      while (!list_empty (slot))
+        wheel_insert (list_entry (list_pop_front (slot), struct timer, elem));
+    }
+
+  /* Detach the slot before running callbacks, so that a callback
+     that re-adds its timer cannot make wheel_run() loop forever.
+     The timers stay pending, so timer_cancel() still works on
+     them. */
+  slot = &wheel[0][now & WHEEL_MASK];
+  if (!list_empty (slot))
+    list_splice (list_end (&wheel_expired), list_begin (slot),
+                 list_end (slot));
+  wheel_next = now + 1;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -237,8 +785,10 @@ real_time_sleep (int64_t num, int32_t denom)
      1 s / TIMER_FREQ ticks
   */
   int64_t ticks = num * TIMER_FREQ / denom;
+  int64_t ns = num * (NSEC_PER_SEC / denom);
 
   ASSERT (intr_get_level () == INTR_ON);
+  ASSERT (NSEC_PER_SEC % denom == 0);
   if (ticks > 0)
     {
       /* We're waiting for at least one full timer tick.  Use
@@ -246,6 +796,12 @@ real_time_sleep (int64_t num, int32_t denom)
          processes. */                
       timer_sleep (ticks); 
     }
+  else if (ns >= HR_SLEEP_MIN_NS && tsc_mult != 0)
+    {
+      /* Less than a tick, but long enough to be worth letting
+         other threads run until a one-shot interrupt. */
+      hr_sleep (ns);
+    }
   else 
     {
       /* Otherwise, use a busy-wait loop for more accurate
@@ -258,6 +814,15 @@ real_time_sleep (int64_t num, int32_t denom)
 static void
 real_time_delay (int64_t num, int32_t denom)
 {
+  /* Spin on the TSC once it has been calibrated. */
+  if (tsc_mult != 0)
+    {
+      int64_t end = timer_now_ns () + num * (NSEC_PER_SEC / denom);
+      while (timer_now_ns () < end)
+        barrier ();
+      return;
+    }
+
   /* Scale the numerator and denominator down by 1000 to avoid
      the possibility of overflow. */
   ASSERT (denom % 1000 == 0);
@@ -1,17 +1,47 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Nanoseconds per second and per timer tick. */
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_TICK (NSEC_PER_SEC / TIMER_FREQ)
+
+/* Function called when a kernel timer expires.  It runs in the
+   timer softirq with interrupts off, so it must not sleep. */
+typedef void timer_func (void *aux);
+
+/* A kernel timer.  Owned by the caller, which must keep it alive
+   until it either expires or is cancelled. */
+struct timer
+  {
+    int64_t expires;            /* Tick at which to call FUNC. */
+    timer_func *func;           /* Function to call. */
+    void *aux;                  /* Argument for FUNC. */
+    bool pending;               /* Queued and not yet expired? */
+    struct list_elem elem;      /* Element in a timer wheel slot. */
+  };
+
+/* Tickless idle.  Controlled by kernel command-line option
+   "-tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
+void timer_idle_enter (void);
+void timer_idle_exit (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_now_ns (void);
+uint64_t timer_cycles (void);
+int64_t timer_cycles_to_ns (uint64_t cycles);
 
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep (int64_t ticks);
@@ -19,6 +49,10 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+/* Kernel timers. */
+void timer_add (struct timer *, int64_t expires, timer_func *, void *aux);
+bool timer_cancel (struct timer *);
+
 /* Busy waits. */
 void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
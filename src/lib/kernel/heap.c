@@ -0,0 +1,196 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Our pairing heap is a multiway tree in which each node is no
+   less than any of its children.  Each node points to its
+   leftmost child and to its siblings, and each node's `prev'
+   points to its left sibling or, for the leftmost child, to its
+   parent, so that any node can be cut out of the tree in
+   constant time.
+
+   The roots of detached trees always have null `next' and
+   `prev' pointers. */
+
+/* Makes the smaller of roots A and B the leftmost child of the
+   other and returns the resulting root. */
+static struct heap_elem *
+link (struct heap *heap, struct heap_elem *a, struct heap_elem *b)
+{
+  if (heap->less (a, b, heap->aux))
+    {
+      struct heap_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+  return a;
+}
+
+/* Melds the list of sibling trees starting at FIRST into a
+   single tree and returns its root, or a null pointer if FIRST
+   is null.  This is the standard two-pass pairing: link
+   adjacent pairs from left to right, then link the results from
+   right to left. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root;
+
+  /* First pass.  PAIRS is a stack, linked through `next', of the
+     trees formed so far. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+
+      a->prev = a->next = NULL;
+      if (b != NULL)
+        {
+          first = b->next;
+          b->prev = b->next = NULL;
+          a = link (heap, a, b);
+        }
+      else
+        first = NULL;
+
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Second pass. */
+  root = pairs;
+  if (root != NULL)
+    {
+      pairs = root->next;
+      root->next = NULL;
+      while (pairs != NULL)
+        {
+          struct heap_elem *t = pairs;
+          pairs = t->next;
+          t->next = NULL;
+          root = link (heap, t, root);
+        }
+    }
+  return root;
+}
+
+/* Detaches the subtree rooted at E, which must not be HEAP's
+   root, from the rest of HEAP. */
+static void
+cut (struct heap_elem *e)
+{
+  ASSERT (e->prev != NULL);
+
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  e->prev = e->next = NULL;
+}
+
+/* Initializes HEAP as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux)
+{
+  ASSERT (heap != NULL);
+  ASSERT (less != NULL);
+
+  heap->root = NULL;
+  heap->size = 0;
+  heap->less = less;
+  heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_insert (struct heap *heap, struct heap_elem *elem)
+{
+  ASSERT (heap != NULL);
+  ASSERT (elem != NULL);
+
+  elem->child = elem->next = elem->prev = NULL;
+  heap->root = heap->root != NULL ? link (heap, heap->root, elem) : elem;
+  heap->size++;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem)
+{
+  struct heap_elem *sub;
+
+  ASSERT (heap != NULL);
+  ASSERT (elem != NULL);
+  ASSERT (heap->size > 0);
+
+  sub = merge_pairs (heap, elem->child);
+  elem->child = NULL;
+  if (elem == heap->root)
+    heap->root = sub;
+  else
+    {
+      cut (elem);
+      if (sub != NULL)
+        heap->root = link (heap, heap->root, sub);
+    }
+  heap->size--;
+}
+
+/* Restores HEAP's ordering after the value of ELEM, which must
+   be in HEAP, has changed. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem)
+{
+  heap_remove (heap, elem);
+  heap_insert (heap, elem);
+}
+
+/* Returns the maximum element in HEAP, or a null pointer if
+   HEAP is empty.  If several elements are maximal, returns any
+   one of them. */
+struct heap_elem *
+heap_max (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->root;
+}
+
+/* Removes and returns the maximum element in HEAP, which must
+   not be empty. */
+struct heap_elem *
+heap_pop_max (struct heap *heap)
+{
+  struct heap_elem *max = heap_max (heap);
+
+  ASSERT (max != NULL);
+  heap_remove (heap, max);
+  return max;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->root == NULL;
+}
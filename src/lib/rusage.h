@@ -0,0 +1,22 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Whose resource usage getrusage() reports. */
+#define RUSAGE_SELF 0           /* The calling process. */
+#define RUSAGE_CHILDREN 1       /* Its children that have exited. */
+
+/* Resource usage of a thread, or the sum over its children. */
+struct rusage
+  {
+    int64_t user_ticks;         /* Timer ticks running a user program. */
+    int64_t kernel_ticks;       /* Timer ticks running in the kernel. */
+    unsigned voluntary_switches;   /* Gave up the CPU by blocking. */
+    unsigned involuntary_switches; /* Preempted or yielded while ready. */
+    unsigned page_faults;       /* Page faults taken. */
+    unsigned blocks_read;       /* Sectors read from block devices. */
+    unsigned blocks_written;    /* Sectors written to block devices. */
+  };
+
+#endif /* lib/rusage.h */
@@ -28,7 +28,12 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Scheduling extensions. */
+    SYS_SCHED_DEADLINE,         /* Enter or leave the EDF class. */
+    SYS_SCHED_YIELD,            /* End the current EDF job. */
+    SYS_GETRUSAGE               /* Report resource usage. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -182,3 +182,21 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+sched_deadline (int runtime, int period, int deadline) 
+{
+  return syscall3 (SYS_SCHED_DEADLINE, runtime, period, deadline);
+}
+
+void
+sched_yield (void) 
+{
+  syscall0 (SYS_SCHED_YIELD);
+}
+
+int
+getrusage (int who, struct rusage *usage) 
+{
+  return syscall2 (SYS_GETRUSAGE, who, usage);
+}
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <rusage.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +46,9 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Scheduling extensions. */
+bool sched_deadline (int runtime, int period, int deadline);
+void sched_yield (void);
+int getrusage (int who, struct rusage *);
+
 #endif /* lib/user/syscall.h */
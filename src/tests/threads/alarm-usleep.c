@@ -0,0 +1,53 @@
+/* Checks that sub-tick sleeps last at least as long as asked
+   and let other threads run instead of busy-waiting.  A
+   PRI_MIN thread spins counting while the main thread sleeps
+   for less than a tick at a time, so it only makes progress if
+   the sleeps yield the CPU. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 10
+#define SLEEP_US 2000
+
+static thread_func spin_thread;
+
+static volatile bool stop;
+static volatile int64_t spins;
+
+void
+test_alarm_usleep (void) 
+{
+  int64_t before;
+  int i;
+
+  stop = false;
+  spins = 0;
+  thread_create ("spinner", PRI_MIN, spin_thread, NULL);
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    {
+      int64_t start = timer_now_ns ();
+      int64_t elapsed;
+
+      before = spins;
+      timer_usleep (SLEEP_US);
+      elapsed = timer_now_ns () - start;
+      if (elapsed < SLEEP_US * 1000)
+        fail ("sleep %d lasted only %lld ns", i, elapsed);
+      if (spins == before)
+        fail ("sleep %d did not let the spinner run", i);
+    }
+  stop = true;
+  msg ("%d sleeps of %d us each let the spinner run.", SLEEP_CNT, SLEEP_US);
+}
+
+static void
+spin_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    spins++;
+}
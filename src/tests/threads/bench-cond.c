@@ -0,0 +1,110 @@
+/* Measures condition variable broadcast fan-out.  The main
+   thread broadcasts to 1 to BENCH_MAX_THREADS waiters and waits
+   until every one of them has woken and reacquired the lock,
+   about WAKEUP_CNT wakeups in all for each count.  Reports the
+   results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WAKEUP_CNT 20000
+#define MIN_ROUNDS 10
+
+static thread_func waiter;
+static void run_broadcasts (int thread_cnt);
+
+static struct lock lock;
+static struct condition go, all_awake;
+static struct semaphore done;
+static int generation;          /* Incremented by each broadcast. */
+static int awake;               /* Waiters that saw GENERATION. */
+static int waiter_cnt;
+static bool stop;
+
+void
+test_bench_cond (void)
+{
+  int thread_cnt;
+
+  for (thread_cnt = 1; thread_cnt <= BENCH_MAX_THREADS; thread_cnt *= 2)
+    run_broadcasts (thread_cnt);
+  pass ();
+}
+
+/* Broadcasts to THREAD_CNT waiters over and over. */
+static void
+run_broadcasts (int thread_cnt)
+{
+  int64_t start, elapsed;
+  int rounds;
+  int i;
+
+  lock_init (&lock);
+  cond_init (&go);
+  cond_init (&all_awake);
+  sema_init (&done, 0);
+  generation = 0;
+  waiter_cnt = thread_cnt;
+  stop = false;
+  rounds = (WAKEUP_CNT / thread_cnt > MIN_ROUNDS
+            ? WAKEUP_CNT / thread_cnt : MIN_ROUNDS);
+
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[sizeof "waiter " + 11];
+      snprintf (name, sizeof name, "waiter %d", i);
+      if (thread_create (name, PRI_DEFAULT, waiter, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+
+  start = timer_now_ns ();
+  lock_acquire (&lock);
+  for (i = 0; i < rounds; i++)
+    {
+      awake = 0;
+      generation++;
+      cond_broadcast (&go, &lock);
+      while (awake < thread_cnt)
+        cond_wait (&all_awake, &lock);
+    }
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  stop = true;
+  generation++;
+  cond_broadcast (&go, &lock);
+  lock_release (&lock);
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+
+  msg ("threads=%d broadcasts=%d wakeups=%d ns=%lld wakeups_per_sec=%lld "
+       "avg_fanout_ns=%lld", thread_cnt, rounds, rounds * thread_cnt,
+       elapsed, (int64_t) rounds * thread_cnt * NSEC_PER_SEC / elapsed,
+       elapsed / rounds);
+}
+
+/* Wakes once for each broadcast until told to stop. */
+static void
+waiter (void *aux UNUSED)
+{
+  int seen = 0;
+
+  lock_acquire (&lock);
+  for (;;)
+    {
+      while (generation == seen)
+        cond_wait (&go, &lock);
+      seen = generation;
+      if (stop)
+        break;
+      if (++awake == waiter_cnt)
+        cond_signal (&all_awake, &lock);
+    }
+  lock_release (&lock);
+  sema_up (&done);
+}
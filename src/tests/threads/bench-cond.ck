@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ("threads", "broadcasts", "wakeups", "ns", "wakeups_per_sec",
+	     "avg_fanout_ns");
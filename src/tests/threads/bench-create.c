@@ -0,0 +1,73 @@
+/* Measures how fast threads can be created and torn down, first
+   with the cache of exited thread pages disabled, so that every
+   thread_create() goes to the page allocator, and then with it
+   enabled.  Threads are created in batches of 1 to
+   BENCH_MAX_THREADS, all of which are alive at once before the
+   batch is reaped.  Reports the results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define CREATE_CNT 2000
+
+static thread_func exit_thread;
+static void run_creates (const char *label, size_t cache_max, int batch);
+
+void
+test_bench_create (void) 
+{
+  size_t saved_max = thread_cache_max;
+  int batch;
+
+  for (batch = 1; batch <= BENCH_MAX_THREADS; batch *= 2)
+    run_creates ("off", 0, batch);
+  for (batch = 1; batch <= BENCH_MAX_THREADS; batch *= 2)
+    run_creates ("on", saved_max > 0 ? saved_max : 32, batch);
+  thread_cache_max = saved_max;
+  pass ();
+}
+
+/* Creates at least CREATE_CNT threads, BATCH at a time, each of
+   which exits as soon as it runs, with the thread cache limited
+   to CACHE_MAX pages. */
+static void
+run_creates (const char *label, size_t cache_max, int batch) 
+{
+  struct semaphore done;
+  int creates = (CREATE_CNT + batch - 1) / batch * batch;
+  int64_t start, elapsed;
+  int i, j;
+
+  thread_cache_max = cache_max;
+  thread_cache_trim (cache_max);
+  sema_init (&done, 0);
+
+  start = timer_now_ns ();
+  for (i = 0; i < creates; i += batch) 
+    {
+      for (j = 0; j < batch; j++)
+        if (thread_create ("bench", PRI_DEFAULT, exit_thread, &done)
+            == TID_ERROR)
+          fail ("thread_create failed after %d threads", i + j);
+      for (j = 0; j < batch; j++)
+        sema_down (&done);
+    }
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  msg ("cache=%s threads=%d creates=%d ns=%lld creates_per_sec=%lld",
+       label, batch, creates, elapsed,
+       (int64_t) creates * NSEC_PER_SEC / elapsed);
+}
+
+static void
+exit_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+  sema_up (done);
+}
@@ -0,0 +1,91 @@
+/* Measures lock handoff with 1 to BENCH_MAX_THREADS contenders of
+   equal priority, about ACQUIRE_CNT acquisitions in all for each
+   count.  Each holder yields once inside its critical section, so
+   that the other contenders queue up on the lock and release
+   normally has to hand it to a waiter.  Reports the results as
+   key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ACQUIRE_CNT 10000
+
+static thread_func contender;
+static void run_contenders (int thread_cnt);
+
+static struct lock lock;
+static struct semaphore done;
+static int acquires_per_thread;
+static int counter;
+
+void
+test_bench_lock (void)
+{
+  int thread_cnt;
+
+  for (thread_cnt = 1; thread_cnt <= BENCH_MAX_THREADS; thread_cnt *= 2)
+    run_contenders (thread_cnt);
+  pass ();
+}
+
+/* Runs THREAD_CNT threads contending for LOCK. */
+static void
+run_contenders (int thread_cnt)
+{
+  int64_t start, elapsed;
+  int acquires;
+  int i;
+
+  lock_init (&lock);
+  sema_init (&done, 0);
+  acquires_per_thread = (ACQUIRE_CNT / thread_cnt > 0
+                         ? ACQUIRE_CNT / thread_cnt : 1);
+  acquires = acquires_per_thread * thread_cnt;
+  counter = 0;
+
+  /* The contenders do not outrank us, so none of them runs until
+     we block below. */
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[sizeof "contender " + 11];
+      snprintf (name, sizeof name, "contender %d", i);
+      if (thread_create (name, PRI_DEFAULT, contender, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+
+  start = timer_now_ns ();
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  if (counter != acquires)
+    fail ("counter is %d after %d acquisitions", counter, acquires);
+  msg ("threads=%d acquires=%d ns=%lld acquires_per_sec=%lld "
+       "ns_per_acquire=%lld", thread_cnt, acquires, elapsed,
+       (int64_t) acquires * NSEC_PER_SEC / elapsed, elapsed / acquires);
+}
+
+/* Acquires LOCK acquires_per_thread times, then exits. */
+static void
+contender (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < acquires_per_thread; i++)
+    {
+      int value;
+
+      lock_acquire (&lock);
+      value = counter;
+      thread_yield ();
+      counter = value + 1;
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
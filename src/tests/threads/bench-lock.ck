@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ("threads", "acquires", "ns", "acquires_per_sec",
+	     "ns_per_acquire");
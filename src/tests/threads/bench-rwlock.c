@@ -0,0 +1,103 @@
+/* Measures throughput of a read-mostly workload, 95% reads and
+   5% writes, protected first by a plain lock and then by a
+   readers-writer lock.  Threads yield inside their critical
+   sections now and then so that they overlap.  Reports the
+   results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 16
+#define OPS_PER_THREAD 5000
+#define WRITE_PERCENT 5
+#define TABLE_SIZE 64
+
+static thread_func worker;
+static void run_mix (const char *label, bool use_rwlock);
+
+static struct lock lock;
+static struct rwlock rwlock;
+static bool use_rwlock;
+static int table[TABLE_SIZE];
+static struct semaphore done;
+
+void
+test_bench_rwlock (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  run_mix ("lock", false);
+  run_mix ("rwlock", true);
+  pass ();
+}
+
+/* Runs THREAD_CNT workers over the shared table, protecting it
+   with a readers-writer lock if RWLOCK_ is true, otherwise with a
+   plain lock. */
+static void
+run_mix (const char *label, bool rwlock_)
+{
+  int64_t start, elapsed;
+  int ops = THREAD_CNT * OPS_PER_THREAD;
+  int i;
+
+  lock_init (&lock);
+  rw_init (&rwlock);
+  sema_init (&done, 0);
+  use_rwlock = rwlock_;
+
+  start = timer_now_ns ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  msg ("lock=%s threads=%d ops=%d write_percent=%d ns=%lld "
+       "ops_per_sec=%lld", label, THREAD_CNT, ops, WRITE_PERCENT, elapsed,
+       (int64_t) ops * NSEC_PER_SEC / elapsed);
+}
+
+static void
+worker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < OPS_PER_THREAD; i++) 
+    {
+      bool write = i % 100 < WRITE_PERCENT;
+      int slot = i % TABLE_SIZE;
+
+      if (!use_rwlock)
+        lock_acquire (&lock);
+      else if (write)
+        rw_write_acquire (&rwlock);
+      else
+        rw_read_acquire (&rwlock);
+
+      if (write)
+        table[slot]++;
+      else if (table[slot] < 0)
+        fail ("table entry %d went negative", slot);
+      if (i % 16 == 0)
+        thread_yield ();
+
+      if (use_rwlock)
+        rw_release (&rwlock);
+      else
+        lock_release (&lock);
+    }
+  sema_up (&done);
+}
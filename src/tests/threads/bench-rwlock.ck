@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ("lock", "threads", "ops", "write_percent", "ns", "ops_per_sec");
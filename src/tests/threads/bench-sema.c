@@ -0,0 +1,86 @@
+/* Measures semaphore ping-pong latency under contention.  With
+   1 to BENCH_MAX_THREADS threads of mixed priorities all waiting
+   on one semaphore, every up has to pick the highest-priority
+   waiter out of the queue.  The main thread bounces control to
+   one of them and back about ROUNDS times.  Reports the results
+   as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUNDS 10000
+
+static thread_func pong_thread;
+static void run_pings (int thread_cnt);
+
+static struct semaphore ping, pong;
+static int rounds_per_thread;
+
+void
+test_bench_sema (void)
+{
+  int thread_cnt;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (thread_cnt = 1; thread_cnt <= BENCH_MAX_THREADS; thread_cnt *= 2)
+    run_pings (thread_cnt);
+  pass ();
+}
+
+/* Bounces between the main thread and THREAD_CNT pong threads. */
+static void
+run_pings (int thread_cnt)
+{
+  int64_t start, elapsed;
+  int rounds;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  rounds_per_thread = ROUNDS / thread_cnt > 0 ? ROUNDS / thread_cnt : 1;
+  rounds = rounds_per_thread * thread_cnt;
+
+  /* The pong threads outrank us, so each one runs until it
+     blocks on PING as soon as it is created. */
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "pong %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1 + i % 16,
+                         pong_thread, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+
+  start = timer_now_ns ();
+  for (i = 0; i < rounds; i++)
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  msg ("threads=%d round_trips=%d ns=%lld round_trips_per_sec=%lld "
+       "avg_latency_ns=%lld", thread_cnt, rounds, elapsed,
+       (int64_t) rounds * NSEC_PER_SEC / elapsed, elapsed / rounds);
+}
+
+/* Answers rounds_per_thread pings, then exits. */
+static void
+pong_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < rounds_per_thread; i++)
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ("threads", "round_trips", "ns", "round_trips_per_sec",
+	     "avg_latency_ns");
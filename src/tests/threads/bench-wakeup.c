@@ -0,0 +1,82 @@
+/* Measures wakeup-to-run latency for sleeping threads.  1 to
+   BENCH_MAX_THREADS threads each sleep SLEEP_CNT times for
+   SLEEP_NS, and record how long after the end of each sleep they
+   got to run again.  Reports the results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 10
+#define SLEEP_NS (NSEC_PER_TICK * 3 / 2)
+
+static thread_func sleeper;
+static void run_sleepers (int thread_cnt);
+
+static struct semaphore done;
+static int64_t latency_sum, latency_max;
+
+void
+test_bench_wakeup (void)
+{
+  int thread_cnt;
+
+  for (thread_cnt = 1; thread_cnt <= BENCH_MAX_THREADS; thread_cnt *= 2)
+    run_sleepers (thread_cnt);
+  pass ();
+}
+
+/* Runs THREAD_CNT sleepers to completion. */
+static void
+run_sleepers (int thread_cnt)
+{
+  int sleeps = SLEEP_CNT * thread_cnt;
+  int i;
+
+  sema_init (&done, 0);
+  latency_sum = latency_max = 0;
+
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[sizeof "sleeper " + 11];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+
+  msg ("threads=%d sleeps=%d sleep_ns=%lld avg_latency_ns=%lld "
+       "max_latency_ns=%lld", thread_cnt, sleeps, (int64_t) SLEEP_NS,
+       latency_sum / sleeps, latency_max);
+}
+
+/* Sleeps SLEEP_CNT times, adding up how late it woke. */
+static void
+sleeper (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    {
+      int64_t deadline = timer_now_ns () + SLEEP_NS;
+      int64_t latency;
+      enum intr_level old_level;
+
+      timer_nsleep (SLEEP_NS);
+      latency = timer_now_ns () - deadline;
+      if (latency < 0)
+        latency = 0;
+
+      old_level = intr_disable ();
+      latency_sum += latency;
+      if (latency > latency_max)
+        latency_max = latency;
+      intr_set_level (old_level);
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,73 @@
+/* Measures work queue throughput and queueing latency.  The
+   main thread submits ITEM_CNT tiny work items to a pool of
+   WORKER_CNT threads, reusing a ring of SLOT_CNT work items and
+   waiting for each slot's previous item before reusing it.
+   Queueing latency is the time from submission until a worker
+   starts the item.  Reports the results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define ITEM_CNT 100000
+#define SLOT_CNT 256
+#define WORKER_CNT 4
+
+static work_func tiny_work;
+
+static struct workqueue wq;
+static struct work works[SLOT_CNT];
+static int64_t submit_ns[SLOT_CNT];
+static int64_t latency_sum, latency_max;
+
+void
+test_bench_workqueue (void) 
+{
+  int64_t start, elapsed;
+  int i;
+
+  workqueue_init (&wq, "bench", PRI_DEFAULT, WORKER_CNT);
+  latency_sum = latency_max = 0;
+
+  start = timer_now_ns ();
+  for (i = 0; i < ITEM_CNT; i++) 
+    {
+      int slot = i % SLOT_CNT;
+
+      work_wait (&works[slot]);
+      submit_ns[slot] = timer_now_ns ();
+      work_submit_on (&wq, &works[slot], tiny_work, &submit_ns[slot]);
+    }
+  for (i = 0; i < SLOT_CNT; i++)
+    work_wait (&works[i]);
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  msg ("workers=%d items=%d ns=%lld items_per_sec=%lld "
+       "avg_latency_ns=%lld max_latency_ns=%lld",
+       WORKER_CNT, ITEM_CNT, elapsed,
+       (int64_t) ITEM_CNT * NSEC_PER_SEC / elapsed,
+       latency_sum / ITEM_CNT, latency_max);
+  pass ();
+}
+
+/* Records the queueing latency of the item submitted at
+   *SUBMIT_NS_. */
+static void
+tiny_work (void *submit_ns_) 
+{
+  int64_t latency = timer_now_ns () - *(int64_t *) submit_ns_;
+  enum intr_level old_level;
+
+  /* The workers preempt each other. */
+  old_level = intr_disable ();
+  latency_sum += latency;
+  if (latency > latency_max)
+    latency_max = latency;
+  intr_set_level (old_level);
+}
@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ("workers", "items", "ns", "items_per_sec", "avg_latency_ns",
+	     "max_latency_ns");
@@ -0,0 +1,75 @@
+/* Measures the cost of thread_yield() with 1 to BENCH_MAX_THREADS
+   threads of equal priority taking turns on the CPU, about
+   YIELD_CNT yields in all for each count.  Each yield is a trip
+   through the scheduler to the next ready thread.  Reports the
+   results as key=value lines. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define YIELD_CNT 20000
+
+static thread_func yield_thread;
+static void run_yields (int thread_cnt);
+
+static struct semaphore done;
+static int yields_per_thread;
+
+void
+test_bench_yield (void)
+{
+  int thread_cnt;
+
+  for (thread_cnt = 1; thread_cnt <= BENCH_MAX_THREADS; thread_cnt *= 2)
+    run_yields (thread_cnt);
+  pass ();
+}
+
+/* Runs THREAD_CNT threads that yield to one another. */
+static void
+run_yields (int thread_cnt)
+{
+  int64_t start, elapsed;
+  int yields;
+  int i;
+
+  sema_init (&done, 0);
+  yields_per_thread = YIELD_CNT / thread_cnt > 0 ? YIELD_CNT / thread_cnt : 1;
+  yields = yields_per_thread * thread_cnt;
+
+  /* The threads do not outrank us, so none of them runs until we
+     block below. */
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[sizeof "yield " + 11];
+      snprintf (name, sizeof name, "yield %d", i);
+      if (thread_create (name, PRI_DEFAULT, yield_thread, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+    }
+
+  start = timer_now_ns ();
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+  elapsed = timer_now_ns () - start;
+  if (elapsed < 1)
+    elapsed = 1;
+
+  msg ("threads=%d yields=%d ns=%lld yields_per_sec=%lld ns_per_yield=%lld",
+       thread_cnt, yields, elapsed,
+       (int64_t) yields * NSEC_PER_SEC / elapsed, elapsed / yields);
+}
+
+/* Yields yields_per_thread times, then exits. */
+static void
+yield_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < yields_per_thread; i++)
+    thread_yield ();
+  sema_up (&done);
+}
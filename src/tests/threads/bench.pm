@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Checks the output of a bench-* test.  Benchmarks report
+# measurements, so rather than comparing against fixed output,
+# this only requires a clean run and at least one result line
+# containing every key in @KEYS as a KEY=VALUE pair.
+sub check_bench {
+    my (@keys) = @_;
+    our ($test);
+
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my ($results) = 0;
+    local ($_);
+    foreach (@output) {
+	fail "$_\n" if /FAIL/;
+	my ($line) = $_;
+	next if grep ($line !~ /\b$_=\S/, @keys);
+	$results++;
+    }
+    fail "No results reported with keys: @keys\n" if !$results;
+    fail "Missing PASS message.\n" if !grep (/\) PASS$/, @output);
+    pass;
+}
+
+1;
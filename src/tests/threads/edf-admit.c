@@ -0,0 +1,54 @@
+/* Checks admission control for the EDF scheduling class.
+
+   Invalid parameters must be rejected.  The main thread reserves
+   90% of the CPU, after which neither it nor another thread may
+   push the total past 95%.  Once the main thread leaves the EDF
+   class, its bandwidth must be available to others again. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reserve_thread_func;
+
+void
+test_edf_admit (void) 
+{
+  struct semaphore done;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("runtime > deadline: %s",
+       thread_set_deadline (5, 10, 4) ? "accepted" : "rejected");
+  msg ("deadline > period: %s",
+       thread_set_deadline (1, 5, 10) ? "accepted" : "rejected");
+  msg ("negative runtime: %s",
+       thread_set_deadline (-1, 10, 10) ? "accepted" : "rejected");
+
+  msg ("Main reserving 90%%: %s",
+       thread_set_deadline (9, 10, 10) ? "accepted" : "rejected");
+  msg ("Main raising to 100%%: %s",
+       thread_set_deadline (10, 10, 10) ? "accepted" : "rejected");
+
+  sema_init (&done, 0);
+  thread_create ("reserve 1", PRI_DEFAULT + 1, reserve_thread_func, &done);
+  sema_down (&done);
+
+  msg ("Main leaving EDF class: %s",
+       thread_set_deadline (0, 0, 0) ? "accepted" : "rejected");
+  thread_create ("reserve 2", PRI_DEFAULT + 1, reserve_thread_func, &done);
+  sema_down (&done);
+}
+
+static void
+reserve_thread_func (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  msg ("%s reserving 10%%: %s", thread_name (),
+       thread_set_deadline (1, 10, 10) ? "accepted" : "rejected");
+  sema_up (done);
+}
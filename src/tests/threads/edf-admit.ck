@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admit) begin
+(edf-admit) runtime > deadline: rejected
+(edf-admit) deadline > period: rejected
+(edf-admit) negative runtime: rejected
+(edf-admit) Main reserving 90%: accepted
+(edf-admit) Main raising to 100%: rejected
+(edf-admit) reserve 1 reserving 10%: rejected
+(edf-admit) Main leaving EDF class: accepted
+(edf-admit) reserve 2 reserving 10%: accepted
+(edf-admit) end
+EOF
+pass;
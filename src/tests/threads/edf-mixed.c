@@ -0,0 +1,88 @@
+/* Runs three periodic EDF threads, reserving 75% of the CPU
+   between them, next to CPU-bound threads at PRI_MAX.  Every
+   job must meet its deadline. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define JOB_CNT 20
+#define HOG_CNT 2
+#define HOG_TICKS 250
+
+struct edf_params 
+  {
+    int runtime, period, deadline;
+  };
+
+static const struct edf_params params[] = 
+  {
+    {2, 5, 5},
+    {2, 10, 10},
+    {3, 20, 20},
+  };
+#define EDF_CNT (sizeof params / sizeof *params)
+
+static struct semaphore done;
+static unsigned total_misses;
+
+static thread_func edf_thread_func;
+static thread_func hog_thread_func;
+
+void
+test_edf_mixed (void) 
+{
+  int64_t start = timer_ticks ();
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  total_misses = 0;
+  for (i = 0; i < EDF_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "edf %zu", i);
+      thread_create (name, PRI_MAX, edf_thread_func, (void *) &params[i]);
+    }
+  for (i = 0; i < HOG_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "hog %zu", i);
+      thread_create (name, PRI_MAX, hog_thread_func, &start);
+    }
+
+  for (i = 0; i < EDF_CNT + HOG_CNT; i++)
+    sema_down (&done);
+  msg ("%zu EDF threads ran %d jobs each with %u deadline misses.",
+       EDF_CNT, JOB_CNT, total_misses);
+}
+
+static void
+edf_thread_func (void *params_) 
+{
+  const struct edf_params *p = params_;
+  int i;
+
+  if (!thread_set_deadline (p->runtime, p->period, p->deadline))
+    fail ("EDF reservation rejected");
+  for (i = 0; i < JOB_CNT; i++)
+    thread_deadline_yield ();
+  total_misses += thread_get_deadline_misses ();
+  thread_set_deadline (0, 0, 0);
+  sema_up (&done);
+}
+
+static void
+hog_thread_func (void *start_) 
+{
+  int64_t *start = start_;
+
+  while (timer_elapsed (*start) < HOG_TICKS)
+    continue;
+  sema_up (&done);
+}
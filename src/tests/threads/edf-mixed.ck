@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-mixed) begin
+(edf-mixed) 3 EDF threads ran 20 jobs each with 0 deadline misses.
+(edf-mixed) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Checks that an EDF thread outranks every priority thread.
+
+   Thread E enters the EDF class and creates thread H at
+   PRI_MAX, which must not run until E ends its job.  While the
+   main thread spins, E's next release must preempt it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+static thread_func e_thread_func;
+static thread_func h_thread_func;
+
+static volatile bool second_job;
+
+void
+test_edf_preempt (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  second_job = false;
+  thread_create ("e", PRI_DEFAULT + 1, e_thread_func, NULL);
+  msg ("Main spinning.");
+  while (!second_job)
+    barrier ();
+  msg ("Main finished.");
+}
+
+static void
+e_thread_func (void *aux UNUSED) 
+{
+  if (!thread_set_deadline (10, 50, 50))
+    fail ("EDF reservation rejected");
+  msg ("Thread E job 1 started.");
+  thread_create ("h", PRI_MAX, h_thread_func, NULL);
+  msg ("Thread E job 1 finished.");
+  thread_deadline_yield ();
+
+  msg ("Thread E job 2 started.");
+  second_job = true;
+  thread_set_deadline (0, 0, 0);
+  msg ("Thread E finished.");
+}
+
+static void
+h_thread_func (void *aux UNUSED) 
+{
+  msg ("Thread H finished.");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-preempt) begin
+(edf-preempt) Thread E job 1 started.
+(edf-preempt) Thread E job 1 finished.
+(edf-preempt) Thread H finished.
+(edf-preempt) Main spinning.
+(edf-preempt) Thread E job 2 started.
+(edf-preempt) Thread E finished.
+(edf-preempt) Main finished.
+(edf-preempt) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Checks that the timer interrupt enforces EDF budgets.
+
+   Thread E reserves 2 ticks out of every 10 and then spins.
+   Because it outranks the main thread, the main thread can only
+   run once E has used up its budget and been throttled. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define OVERRUN_CNT 3
+
+static thread_func e_thread_func;
+
+void
+test_edf_throttle (void) 
+{
+  struct semaphore done;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  thread_create ("e", PRI_DEFAULT + 1, e_thread_func, &done);
+  msg ("Main thread got the CPU while E was spinning.");
+  sema_down (&done);
+  msg ("Main thread finished.");
+}
+
+static void
+e_thread_func (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  if (!thread_set_deadline (2, 10, 10))
+    fail ("EDF reservation rejected");
+  while (thread_get_deadline_overruns () < OVERRUN_CNT)
+    continue;
+  thread_set_deadline (0, 0, 0);
+  msg ("Thread E was throttled %d times.", OVERRUN_CNT);
+  sema_up (done);
+}
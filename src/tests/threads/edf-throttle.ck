@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-throttle) begin
+(edf-throttle) Main thread got the CPU while E was spinning.
+(edf-throttle) Thread E was throttled 3 times.
+(edf-throttle) Main thread finished.
+(edf-throttle) end
+EOF
+pass;
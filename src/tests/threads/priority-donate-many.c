@@ -0,0 +1,68 @@
+/* The main thread acquires a lock, then creates many threads of
+   higher, scrambled priorities that all try to acquire it.  The
+   main thread's priority must rise to the highest of them, and
+   once the lock is released the threads must obtain it in
+   priority order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 100
+
+static thread_func acquire_thread_func;
+
+static struct lock lock;
+static int order[THREAD_CNT];
+static int order_cnt;
+
+void
+test_priority_donate_many (void) 
+{
+  int max_priority = PRI_DEFAULT;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&lock);
+  lock_acquire (&lock);
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      int priority = PRI_DEFAULT + 1 + (i * 7) % (PRI_MAX - PRI_DEFAULT);
+      char name[16];
+
+      snprintf (name, sizeof name, "acquire %d", i);
+      thread_create (name, priority, acquire_thread_func, NULL);
+      if (priority > max_priority)
+        max_priority = priority;
+    }
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       max_priority, thread_get_priority ());
+
+  lock_release (&lock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  if (order_cnt != THREAD_CNT)
+    fail ("only %d of %d threads acquired the lock", order_cnt, THREAD_CNT);
+  for (i = 1; i < order_cnt; i++)
+    if (order[i] > order[i - 1])
+      fail ("acquisition %d had priority %d, after one with priority %d",
+            i, order[i], order[i - 1]);
+  msg ("All %d threads acquired the lock in priority order.", THREAD_CNT);
+}
+
+static void
+acquire_thread_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  order[order_cnt++] = thread_get_priority ();
+  lock_release (&lock);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-many) begin
+(priority-donate-many) Main thread should have priority 63.  Actual priority: 63.
+(priority-donate-many) Main thread should have priority 31.  Actual priority: 31.
+(priority-donate-many) All 100 threads acquired the lock in priority order.
+(priority-donate-many) end
+EOF
+pass;
@@ -0,0 +1,82 @@
+/* Checks that a writer blocked on a readers-writer lock donates
+   its priority to every reader holding the lock.
+
+   The main thread and thread R (priority 32) both hold the lock
+   for reading, R while blocked on a semaphore.  Writer W
+   (priority 41) then blocks on the lock, raising both to 41.
+   Thread M (priority 36) is created but cannot run yet.  When
+   the main thread wakes R and releases the lock, R must run
+   ahead of M on the priority donated by W, and once R releases
+   the lock, W must run, then M, then R at its own priority. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_and_sema 
+  {
+    struct rwlock rw;
+    struct semaphore sema;
+  };
+
+static thread_func r_thread_func;
+static thread_func w_thread_func;
+static thread_func m_thread_func;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock_and_sema rs;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rs.rw);
+  sema_init (&rs.sema, 0);
+  rw_read_acquire (&rs.rw);
+
+  thread_create ("r", PRI_DEFAULT + 1, r_thread_func, &rs);
+  thread_create ("w", PRI_DEFAULT + 10, w_thread_func, &rs);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+
+  thread_create ("m", PRI_DEFAULT + 5, m_thread_func, NULL);
+  sema_up (&rs.sema);
+  rw_release (&rs.rw);
+  msg ("Main thread finished.");
+}
+
+static void
+r_thread_func (void *rs_) 
+{
+  struct rwlock_and_sema *rs = rs_;
+
+  rw_read_acquire (&rs->rw);
+  msg ("Thread R got read lock.");
+  sema_down (&rs->sema);
+  msg ("Thread R releasing read lock.");
+  rw_release (&rs->rw);
+  msg ("Thread R finished.");
+}
+
+static void
+w_thread_func (void *rs_) 
+{
+  struct rwlock_and_sema *rs = rs_;
+
+  rw_write_acquire (&rs->rw);
+  msg ("Thread W got write lock.");
+  rw_release (&rs->rw);
+  msg ("Thread W finished.");
+}
+
+static void
+m_thread_func (void *aux UNUSED) 
+{
+  msg ("Thread M finished.");
+}
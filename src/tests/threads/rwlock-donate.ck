@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) Thread R got read lock.
+(rwlock-donate) Main thread should have priority 41.  Actual priority: 41.
+(rwlock-donate) Thread R releasing read lock.
+(rwlock-donate) Thread W got write lock.
+(rwlock-donate) Thread W finished.
+(rwlock-donate) Thread M finished.
+(rwlock-donate) Thread R finished.
+(rwlock-donate) Main thread finished.
+(rwlock-donate) end
+EOF
+pass;
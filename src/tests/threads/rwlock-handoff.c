@@ -0,0 +1,53 @@
+/* The main thread holds a readers-writer lock for reading while
+   a higher-priority writer waits for it.  The main thread then
+   raises its own priority above the writer's and releases the
+   lock, so the writer is woken but does not get to run.  When the
+   main thread asks for the lock for reading again, it must wait
+   behind the writer that the lock was handed to, rather than
+   slipping in ahead of it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+
+void
+test_rwlock_handoff (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+
+  thread_set_priority (PRI_DEFAULT + 2);
+  rw_release (&rw);
+  msg ("Writer should not have run yet.");
+
+  rw_read_acquire (&rw);
+  msg ("Main thread got read lock.");
+  rw_release (&rw);
+
+  thread_set_priority (PRI_DEFAULT);
+  msg ("Writer should have finished.");
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("writer: got write lock");
+  rw_release (rw);
+  msg ("writer: done");
+}
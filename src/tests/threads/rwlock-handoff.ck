@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-handoff) begin
+(rwlock-handoff) Writer should not have run yet.
+(rwlock-handoff) writer: got write lock
+(rwlock-handoff) Main thread got read lock.
+(rwlock-handoff) writer: done
+(rwlock-handoff) Writer should have finished.
+(rwlock-handoff) end
+EOF
+pass;
@@ -0,0 +1,64 @@
+/* The main thread acquires a readers-writer lock for reading.
+   Several higher-priority readers must be able to acquire it
+   for reading at the same time, but a writer must wait until
+   the main thread releases it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define READER_CNT 3
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_read (void) 
+{
+  struct rwlock rw;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+
+  for (i = 0; i < READER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT + 1, reader_thread_func, &rw);
+    }
+  msg ("Readers should have finished while main held the read lock.");
+
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("Writer should be waiting.");
+
+  rw_release (&rw);
+  msg ("Writer should have finished.");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("%s: got read lock", thread_name ());
+  rw_release (rw);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("writer: got write lock");
+  rw_release (rw);
+  msg ("writer: done");
+}
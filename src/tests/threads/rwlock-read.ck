@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-read) begin
+(rwlock-read) reader 0: got read lock
+(rwlock-read) reader 0: done
+(rwlock-read) reader 1: got read lock
+(rwlock-read) reader 1: done
+(rwlock-read) reader 2: got read lock
+(rwlock-read) reader 2: done
+(rwlock-read) Readers should have finished while main held the read lock.
+(rwlock-read) Writer should be waiting.
+(rwlock-read) writer: got write lock
+(rwlock-read) writer: done
+(rwlock-read) Writer should have finished.
+(rwlock-read) end
+EOF
+pass;
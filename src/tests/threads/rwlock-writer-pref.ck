@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) Main thread should have priority 33.  Actual priority: 33.
+(rwlock-writer-pref) writer: got write lock
+(rwlock-writer-pref) reader: got read lock
+(rwlock-writer-pref) reader: done
+(rwlock-writer-pref) writer: done
+(rwlock-writer-pref) Reader and writer should have finished, writer first.
+(rwlock-writer-pref) Main thread should have priority 31.  Actual priority: 31.
+(rwlock-writer-pref) end
+EOF
+pass;
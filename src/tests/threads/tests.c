@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-usleep", test_alarm_usleep},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,6 +26,16 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-many", test_priority_donate_many},
+    {"rwlock-read", test_rwlock_read},
+    {"rwlock-writer-pref", test_rwlock_writer_pref},
+    {"rwlock-donate", test_rwlock_donate},
+    {"rwlock-handoff", test_rwlock_handoff},
+    {"edf-admit", test_edf_admit},
+    {"edf-preempt", test_edf_preempt},
+    {"edf-throttle", test_edf_throttle},
+    {"edf-mixed", test_edf_mixed},
+    {"workqueue", test_workqueue},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -38,6 +49,14 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"bench-create", test_bench_create},
+    {"bench-sema", test_bench_sema},
+    {"bench-rwlock", test_bench_rwlock},
+    {"bench-workqueue", test_bench_workqueue},
+    {"bench-yield", test_bench_yield},
+    {"bench-lock", test_bench_lock},
+    {"bench-cond", test_bench_cond},
+    {"bench-wakeup", test_bench_wakeup},
   };
 
 static const char *test_name;
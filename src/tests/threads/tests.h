@@ -11,6 +11,7 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_usleep;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,6 +20,16 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_many;
+extern test_func test_rwlock_read;
+extern test_func test_rwlock_writer_pref;
+extern test_func test_rwlock_donate;
+extern test_func test_rwlock_handoff;
+extern test_func test_edf_admit;
+extern test_func test_edf_preempt;
+extern test_func test_edf_throttle;
+extern test_func test_edf_mixed;
+extern test_func test_workqueue;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
@@ -32,6 +43,18 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_bench_create;
+extern test_func test_bench_sema;
+extern test_func test_bench_rwlock;
+extern test_func test_bench_workqueue;
+extern test_func test_bench_yield;
+extern test_func test_bench_lock;
+extern test_func test_bench_cond;
+extern test_func test_bench_wakeup;
+
+/* The bench-* tests repeat each measurement with 1, 2, 4, ...,
+   BENCH_MAX_THREADS threads. */
+#define BENCH_MAX_THREADS 512
 
 void msg (const char *, ...);
 void fail (const char *, ...);
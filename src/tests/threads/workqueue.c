@@ -0,0 +1,47 @@
+/* Checks that a work queue runs items in order in its own
+   thread, that a queued item can be cancelled, and that
+   work_wait() waits for completion.
+
+   The queue's single worker runs below the main thread's
+   priority, so nothing runs until the main thread blocks in
+   work_wait(). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+static work_func report;
+
+static struct workqueue wq;
+
+void
+test_workqueue (void) 
+{
+  struct work a = { .state = WORK_IDLE };
+  struct work b = { .state = WORK_IDLE };
+  struct work c = { .state = WORK_IDLE };
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  workqueue_init (&wq, "test", PRI_DEFAULT - 1, 1);
+  work_submit_on (&wq, &a, report, "A");
+  work_submit_on (&wq, &b, report, "B");
+  work_submit_on (&wq, &c, report, "C");
+  msg ("Submitted A, B, C.");
+
+  msg ("Cancel B: %s", work_cancel (&b) ? "cancelled" : "too late");
+  work_wait (&c);
+  msg ("C finished.");
+  msg ("Cancel A: %s", work_cancel (&a) ? "cancelled" : "too late");
+  work_wait (&b);
+  msg ("Waiting for cancelled B returned.");
+}
+
+static void
+report (void *name) 
+{
+  msg ("%s ran in %s.", (const char *) name, thread_name ());
+}
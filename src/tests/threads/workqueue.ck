@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Submitted A, B, C.
+(workqueue) Cancel B: cancelled
+(workqueue) A ran in test/0.
+(workqueue) C ran in test/0.
+(workqueue) C finished.
+(workqueue) Cancel A: too late
+(workqueue) Waiting for cancelled B returned.
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Child process run by rusage test.
+   Spins for 2 timer ticks of user CPU time and terminates.
+   Given the argument "kernel", spins in system calls instead
+   until it has 2 ticks of kernel CPU time. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-rusage";
+
+int
+main (int argc, char *argv[]) 
+{
+  struct rusage ru;
+
+  msg ("run");
+  if (argc > 1 && !strcmp (argv[1], "kernel"))
+    {
+      do
+        getrusage (RUSAGE_SELF, &ru);
+      while (ru.kernel_ticks < 2);
+      return 43;
+    }
+
+  do
+    {
+      volatile int i;
+      for (i = 0; i < 100000; i++)
+        continue;
+      getrusage (RUSAGE_SELF, &ru);
+    }
+  while (ru.user_ticks < 2);
+  return 42;
+}
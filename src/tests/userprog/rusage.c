@@ -0,0 +1,36 @@
+/* Checks that getrusage() reports the CPU time of the calling
+   process, and that of its children once they have been waited
+   for, with time spent in system calls charged as kernel
+   time. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct rusage ru;
+
+  CHECK (getrusage (RUSAGE_SELF, &ru) == 0, "getrusage(RUSAGE_SELF)");
+  while (ru.user_ticks < 2)
+    getrusage (RUSAGE_SELF, &ru);
+  msg ("spun for 2 ticks");
+
+  getrusage (RUSAGE_CHILDREN, &ru);
+  CHECK (ru.user_ticks == 0, "no children accounted yet");
+
+  msg ("wait(exec()) = %d", wait (exec ("child-rusage")));
+  getrusage (RUSAGE_CHILDREN, &ru);
+  CHECK (ru.user_ticks >= 2, "child's ticks accounted");
+
+  msg ("wait(exec()) = %d", wait (exec ("child-rusage kernel")));
+  getrusage (RUSAGE_CHILDREN, &ru);
+  CHECK (ru.kernel_ticks >= 2, "child's system call ticks accounted");
+
+  getrusage (RUSAGE_SELF, &ru);
+  CHECK (ru.voluntary_switches > 0, "waiting counted as a voluntary switch");
+
+  CHECK (getrusage (RUSAGE_CHILDREN + 1, &ru) == -1,
+         "getrusage(invalid) fails");
+}
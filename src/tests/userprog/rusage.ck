@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rusage) begin
+(rusage) getrusage(RUSAGE_SELF)
+(rusage) spun for 2 ticks
+(rusage) no children accounted yet
+(child-rusage) run
+child-rusage: exit(42)
+(rusage) wait(exec()) = 42
+(rusage) child's ticks accounted
+(child-rusage) run
+child-rusage: exit(43)
+(rusage) wait(exec()) = 43
+(rusage) child's system call ticks accounted
+(rusage) waiting counted as a voluntary switch
+(rusage) getrusage(invalid) fails
+(rusage) end
+rusage: exit(0)
+EOF
+pass;
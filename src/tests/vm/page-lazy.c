@@ -0,0 +1,32 @@
+/* Checks that the pages of an executable's data segment are
+   only read in when they are first touched, by counting the page
+   faults taken while touching each page of a large initialized
+   array. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 64
+
+/* Initialized, so that it is read from the executable rather
+   than zero-filled. */
+static char buf[PAGE_CNT * 4096] = { 1 };
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  size_t i;
+
+  getrusage (RUSAGE_SELF, &before);
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * 4096] != (i == 0))
+      fail ("byte %zu of buf is %d", i * 4096, buf[i * 4096]);
+  getrusage (RUSAGE_SELF, &after);
+
+  /* The first page of BUF may share a page with data that was
+     touched already. */
+  CHECK (after.page_faults - before.page_faults >= PAGE_CNT - 1,
+         "touching %d pages faulted them in", PAGE_CNT);
+}
@@ -0,0 +1,14 @@
+/* Try to write to the code segment using getrusage(), which
+   writes its result from the kernel.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  getrusage (RUSAGE_SELF, (struct rusage *) test_main);
+  fail ("survived getrusage into code segment");
+}
@@ -17,11 +17,14 @@
 #include "devices/rtc.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/lockstat.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -37,6 +40,12 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -54,6 +63,9 @@ static const char *swap_bdev_name;
 #endif
 #endif /* FILESYS */
 
+/* -trace, -trace-dump: Record scheduler events? */
+static bool trace_option;
+
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
@@ -97,6 +109,8 @@ main (void)
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
+  if (trace_option)
+    trace_init ();
   paging_init ();
 
   /* Segmentation. */
@@ -113,12 +127,14 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
   serial_init_queue ();
   timer_calibrate ();
+  workqueue_init_system ();
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -127,6 +143,13 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init ();
+  share_init ();
+  swap_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -256,9 +279,46 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-tcache"))
+        {
+          int cnt = atoi (value);
+          if (cnt < 0)
+            PANIC ("-tcache=%s: count must not be negative", value);
+          thread_cache_max = cnt;
+        }
+      else if (!strcmp (name, "-pzero"))
+        {
+          int cnt = atoi (value);
+          if (cnt < 0)
+            PANIC ("-pzero=%s: count must not be negative", value);
+          palloc_zero_target = cnt;
+        }
+      else if (!strcmp (name, "-stats"))
+        thread_stats = true;
+      else if (!strcmp (name, "-lockstat"))
+#ifdef LOCKSTAT
+        lockstat_enabled = true;
+#else
+        PANIC ("-lockstat requires a kernel built with \"make LOCKSTAT=1\"");
+#endif
+      else if (!strcmp (name, "-trace"))
+        trace_option = true;
+      else if (!strcmp (name, "-trace-dump"))
+        trace_option = trace_dump_at_shutdown = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-stack"))
+        {
+          int kb = atoi (value);
+          if (kb < 0)
+            PANIC ("-stack=%s: size must not be negative", value);
+          page_stack_limit = (size_t) kb * 1024;
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -379,8 +439,18 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -tickless          Stop the timer tick while idle.\n"
+          "  -tcache=COUNT      Keep up to COUNT exited thread pages for reuse.\n"
+          "  -pzero=COUNT       Keep up to COUNT pre-zeroed pages per pool.\n"
+          "  -stats             Print per-thread resource usage.\n"
+          "  -lockstat          Print lock contention statistics (LOCKSTAT=1).\n"
+          "  -trace             Record scheduler events in memory.\n"
+          "  -trace-dump        Like -trace, and save them to scratch at shutdown.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -stack=KB          Limit each process's stack to KB kB (default 8192).\n"
 #endif
           );
   shutdown_power_off ();
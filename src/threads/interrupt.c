@@ -47,6 +47,29 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Softirqs raised and not yet run, in the order raised.  After
+   acknowledging an external interrupt, intr_handler() runs up
+   to SOFTIRQ_BUDGET of them with interrupts on, leaving the rest
+   for the next interrupt so that one drain cannot run long.
+   External interrupts that arrive meanwhile do not drain the
+   queue or yield themselves; they leave both to the drain they
+   interrupted. */
+#define SOFTIRQ_BUDGET 16
+static struct list softirq_queue;
+static bool in_softirq;         /* Are we running softirqs? */
+static long long softirq_cnt;   /* # of softirqs run. */
+static long long softirq_deferred_cnt;  /* # of drains cut short. */
+
+#ifdef INTRSTAT
+/* Longest time for which interrupts have been off, in TSC
+   cycles, and the TSC when they were last turned off, or 0 if
+   they are on.  Tracking them reads the TSC on every change of
+   interrupt level, so it is compiled in only by "make
+   INTRSTAT=1". */
+static uint64_t intr_off_max;
+static uint64_t intr_off_since;
+#endif
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -59,6 +82,13 @@ static inline uint64_t make_idtr_operand (uint16_t limit, void *base);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 static void unexpected_interrupt (const struct intr_frame *);
+static void softirq_drain (void);
+
+#ifdef INTRSTAT
+/* Interrupts-off instrumentation. */
+static void intr_off_begin (void);
+static void intr_off_end (void);
+#endif
 
 /* Returns the current interrupt status. */
 enum intr_level
@@ -88,7 +118,12 @@ enum intr_level
 intr_enable (void) 
 {
   enum intr_level old_level = intr_get_level ();
-  ASSERT (!intr_context ());
+  ASSERT (!in_external_intr);
+
+#ifdef INTRSTAT
+  if (old_level == INTR_OFF)
+    intr_off_end ();
+#endif
 
   /* Enable interrupts by setting the interrupt flag.
 
@@ -110,6 +145,10 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+#ifdef INTRSTAT
+  if (old_level == INTR_ON)
+    intr_off_begin ();
+#endif
   return old_level;
 }
 
@@ -122,6 +161,7 @@ intr_init (void)
 
   /* Initialize interrupt controller. */
   pic_init ();
+  list_init (&softirq_queue);
 
   /* Initialize IDT. */
   for (i = 0; i < INTR_CNT; i++)
@@ -206,18 +246,18 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
   register_handler (vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt or a
+   softirq and false at all other times. */
 bool
 intr_context (void) 
 {
-  return in_external_intr;
+  return in_external_intr || in_softirq;
 }
 
-/* During processing of an external interrupt, directs the
-   interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+/* During processing of an external interrupt or a softirq,
+   directs the interrupt handler to yield to a new process just
+   before returning from the interrupt.  May not be called at any
+   other time. */
 void
 intr_yield_on_return (void) 
 {
@@ -347,6 +387,15 @@ intr_handler (struct intr_frame *frame)
   bool external;
   intr_handler_func *handler;
 
+#ifdef INTRSTAT
+  /* The CPU turned interrupts off on the way in if the gate
+     asked it to.  If they were on before, time that from now. */
+  if (frame->eflags & FLAG_IF)
+    intr_off_since = 0;
+  if (intr_get_level () == INTR_OFF)
+    intr_off_begin ();
+#endif
+
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
      and they need to be acknowledged on the PIC (see below).
@@ -355,10 +404,14 @@ intr_handler (struct intr_frame *frame)
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
-      ASSERT (!intr_context ());
+      ASSERT (!in_external_intr);
 
       in_external_intr = true;
-      yield_on_return = false;
+      if (!in_softirq)
+        yield_on_return = false;
+
+      /* Account for any ticks skipped by a tickless idle. */
+      timer_idle_exit ();
     }
 
   /* Invoke the interrupt's handler. */
@@ -383,10 +436,120 @@ intr_handler (struct intr_frame *frame)
       in_external_intr = false;
       pic_end_of_interrupt (frame->vec_no); 
 
-      if (yield_on_return) 
-        thread_yield (); 
+      if (!in_softirq) 
+        {
+          softirq_drain ();
+          if (yield_on_return) 
+            thread_yield (); 
+        }
+    }
+
+#ifdef INTRSTAT
+  /* Returning to code that had interrupts on. */
+  if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+    intr_off_end ();
+#endif
+}
+
+/* Runs up to SOFTIRQ_BUDGET queued softirqs, each with
+   interrupts on.  Called by intr_handler() with interrupts off,
+   at the end of an external interrupt. */
+static void
+softirq_drain (void) 
+{
+  int budget;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  in_softirq = true;
+  for (budget = SOFTIRQ_BUDGET; budget > 0 && !list_empty (&softirq_queue);
+       budget--)
+    {
+      struct softirq *s = list_entry (list_pop_front (&softirq_queue),
+                                      struct softirq, elem);
+      s->pending = false;
+      softirq_cnt++;
+
+      intr_enable ();
+      s->func (s->aux);
+      intr_disable ();
+    }
+  if (!list_empty (&softirq_queue))
+    softirq_deferred_cnt++;
+  in_softirq = false;
+}
+
+/* Initializes softirq S to call FUNC with AUX. */
+void
+softirq_init (struct softirq *s, softirq_func *func, void *aux) 
+{
+  ASSERT (s != NULL);
+  ASSERT (func != NULL);
+
+  s->func = func;
+  s->aux = aux;
+  s->pending = false;
+}
+
+/* Queues softirq S to run at the end of the current external
+   interrupt, or of the next one if called outside an interrupt.
+   Does nothing if S is already queued. */
+void
+softirq_raise (struct softirq *s) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (!s->pending) 
+    {
+      s->pending = true;
+      list_push_back (&softirq_queue, &s->elem);
+    }
+  intr_set_level (old_level);
+}
+
+/* Returns true if any softirq is waiting to run. */
+bool
+softirq_pending (void) 
+{
+  return !list_empty (&softirq_queue);
+}
+
+#ifdef INTRSTAT
+/* Notes that interrupts have just been turned off. */
+static void
+intr_off_begin (void) 
+{
+  if (intr_off_since == 0)
+    intr_off_since = timer_cycles ();
+}
+
+/* Notes that interrupts are about to be turned on, recording how
+   long they were off. */
+static void
+intr_off_end (void) 
+{
+  if (intr_off_since != 0)
+    {
+      uint64_t cycles = timer_cycles () - intr_off_since;
+      if (cycles > intr_off_max)
+        intr_off_max = cycles;
+      intr_off_since = 0;
     }
 }
+#endif /* INTRSTAT */
+
+/* Prints softirq and interrupt latency statistics. */
+void
+intr_print_stats (void) 
+{
+  printf ("Interrupts: %lld softirqs run, %lld drains cut short",
+          softirq_cnt, softirq_deferred_cnt);
+#ifdef INTRSTAT
+  printf (", longest %"PRId64" us with interrupts off",
+          timer_cycles_to_ns (intr_off_max) / 1000);
+#endif
+  printf ("\n");
+}
 
 /* Handles an unexpected interrupt with interrupt frame F.  An
    unexpected interrupt is one that has no registered handler. */
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -63,6 +64,25 @@ void intr_register_int (uint8_t vec, int dpl, enum intr_level,
                         intr_handler_func *, const char *name);
 bool intr_context (void);
 void intr_yield_on_return (void);
+void intr_print_stats (void);
+
+/* Deferred work ("softirq").  An external interrupt handler
+   raises a softirq to have FUNC called with AUX once the
+   interrupt has been acknowledged, with interrupts turned back
+   on.  FUNC still runs in interrupt context: it may not sleep,
+   but it may call intr_yield_on_return(). */
+typedef void softirq_func (void *aux);
+struct softirq
+  {
+    softirq_func *func;         /* Function to call. */
+    void *aux;                  /* Argument for FUNC. */
+    bool pending;               /* Raised and not yet run? */
+    struct list_elem elem;      /* Element in softirq queue. */
+  };
+
+void softirq_init (struct softirq *, softirq_func *, void *aux);
+void softirq_raise (struct softirq *);
+bool softirq_pending (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
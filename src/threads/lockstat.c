@@ -0,0 +1,203 @@
+#include "threads/lockstat.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Number of distinct names we can count separately.  Objects
+   whose names do not fit share the overflow entry. */
+#define LOCKSTAT_CNT 256
+
+/* Number of names printed at shutdown. */
+#define LOCKSTAT_TOP 20
+
+/* Counting enabled?  Controlled by kernel command-line option
+   "-lockstat". */
+bool lockstat_enabled;
+
+/* Open-addressed table of counters, indexed by name hash. */
+static struct lockstat lockstats[LOCKSTAT_CNT];
+static struct lockstat lockstat_overflow = { .name = "(other)" };
+
+/* Strips the leading "../" components that the build adds to
+   __FILE__ from NAME. */
+static const char *
+strip_dotdot (const char *name)
+{
+  while (!memcmp (name, "../", 3))
+    name += 3;
+  return name;
+}
+
+/* Returns the counters for locks (or semaphores, if IS_SEMA) named
+   NAME, creating them if necessary.  NAME must be a string that
+   is never freed, typically a literal. */
+struct lockstat *
+lockstat_register (const char *name, bool is_sema)
+{
+  struct lockstat *ls = NULL;
+  enum intr_level old_level;
+  unsigned h, i;
+
+  name = strip_dotdot (name);
+  h = hash_string (name);
+
+  old_level = intr_disable ();
+  for (i = 0; i < LOCKSTAT_CNT; i++)
+    {
+      struct lockstat *p = &lockstats[(h + i) % LOCKSTAT_CNT];
+      if (p->name == NULL)
+        {
+          p->name = name;
+          p->is_sema = is_sema;
+          ls = p;
+          break;
+        }
+      else if (p->is_sema == is_sema && !strcmp (p->name, name))
+        {
+          ls = p;
+          break;
+        }
+    }
+  if (ls == NULL)
+    ls = &lockstat_overflow;
+  ls->objects++;
+  intr_set_level (old_level);
+
+  return ls;
+}
+
+/* Returns the current time in nanoseconds if counting is
+   enabled, otherwise 0. */
+int64_t
+lockstat_now (void)
+{
+  if (!lockstat_enabled)
+    return 0;
+  return timer_now_ns () + 1;
+}
+
+/* Counts an acquisition of LS and returns the time at which it
+   happened, for lockstat_released().  Interrupts must be off. */
+int64_t
+lockstat_acquired (struct lockstat *ls)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!lockstat_enabled || ls == NULL)
+    return 0;
+  ls->acquired++;
+  return lockstat_now ();
+}
+
+/* Counts a contended acquisition of LS, whose wait began at
+   WAIT_START, as returned by lockstat_now().  Interrupts must be
+   off. */
+void
+lockstat_waited (struct lockstat *ls, int64_t wait_start)
+{
+  int64_t wait;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!lockstat_enabled || ls == NULL || wait_start == 0)
+    return;
+  wait = lockstat_now () - wait_start;
+  ls->contended++;
+  ls->wait_total += wait;
+  if (wait > ls->wait_max)
+    ls->wait_max = wait;
+}
+
+/* Counts a release of LS, which was acquired at HELD_SINCE, as
+   returned by lockstat_acquired().  Interrupts must be off. */
+void
+lockstat_released (struct lockstat *ls, int64_t held_since)
+{
+  int64_t hold;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!lockstat_enabled || ls == NULL || held_since == 0)
+    return;
+  hold = lockstat_now () - held_since;
+  if (hold > ls->hold_max)
+    ls->hold_max = hold;
+}
+
+/* Counts a priority donation by DONOR through LS.  Interrupts
+   must be off. */
+void
+lockstat_donated (struct lockstat *ls, const struct thread *donor)
+{
+  char *p;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!lockstat_enabled || ls == NULL)
+    return;
+  ls->donations++;
+  ls->last_donor = donor->tid;
+  strlcpy (ls->last_donor_name, donor->name, sizeof ls->last_donor_name);
+
+  /* Keep the output one KEY=VALUE pair per field. */
+  for (p = ls->last_donor_name; *p != '\0'; p++)
+    if (*p == ' ')
+      *p = '_';
+}
+
+/* Orders lockstats by descending total wait, then by descending
+   contended acquisitions, then by name. */
+static int
+lockstat_compare (const void *a_, const void *b_)
+{
+  const struct lockstat *a = *(const struct lockstat **) a_;
+  const struct lockstat *b = *(const struct lockstat **) b_;
+
+  if (a->wait_total != b->wait_total)
+    return a->wait_total > b->wait_total ? -1 : 1;
+  if (a->contended != b->contended)
+    return a->contended > b->contended ? -1 : 1;
+  return strcmp (a->name, b->name);
+}
+
+/* Prints the LOCKSTAT_TOP most contended names, one per line.
+   Every field but the name is a KEY=VALUE pair without spaces;
+   the name comes last and runs to the end of the line, because
+   an initializing expression may contain spaces. */
+void
+lockstat_print_stats (void)
+{
+  static struct lockstat *sorted[LOCKSTAT_CNT + 1];
+  size_t cnt = 0;
+  size_t i;
+
+  if (!lockstat_enabled)
+    return;
+
+  for (i = 0; i < LOCKSTAT_CNT; i++)
+    if (lockstats[i].name != NULL && lockstats[i].acquired > 0)
+      sorted[cnt++] = &lockstats[i];
+  if (lockstat_overflow.acquired > 0)
+    sorted[cnt++] = &lockstat_overflow;
+  qsort (sorted, cnt, sizeof *sorted, lockstat_compare);
+
+  printf ("Lockstat: %zu of %zu names\n",
+          cnt < LOCKSTAT_TOP ? cnt : LOCKSTAT_TOP, cnt);
+  for (i = 0; i < cnt && i < LOCKSTAT_TOP; i++)
+    {
+      const struct lockstat *ls = sorted[i];
+      printf ("lockstat: type=%s objects=%u acquired=%llu contended=%llu "
+              "wait_total_ns=%lld wait_max_ns=%lld hold_max_ns=%lld "
+              "donations=%llu last_donor=%d last_donor_name=%s name=%s\n",
+              ls->is_sema ? "sema" : "lock", ls->objects,
+              ls->acquired, ls->contended,
+              ls->wait_total, ls->wait_max, ls->hold_max,
+              ls->donations, ls->last_donor,
+              ls->last_donor != 0 ? ls->last_donor_name : "-", ls->name);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Lock contention statistics.
+
+   Only kernels built with "make LOCKSTAT=1" contain this code;
+   otherwise struct lock and struct semaphore carry no extra
+   members and their operations no extra instructions.  In such a
+   kernel, lock_init() and sema_init() are macros that name each
+   object after the source file and expression that initialized
+   it, and all objects with the same name share one set of
+   counters.  Counting starts when the "-lockstat" kernel option
+   is given, and lockstat_print_stats() then prints the most
+   contended names at shutdown. */
+
+struct thread;
+
+/* Counters for all the locks or semaphores with one name. */
+struct lockstat
+  {
+    const char *name;           /* "file:expression". */
+    bool is_sema;               /* Semaphore rather than lock? */
+    unsigned objects;           /* Number initialized with this name. */
+    uint64_t acquired;          /* Successful acquisitions. */
+    uint64_t contended;         /* Acquisitions that had to wait. */
+    int64_t wait_total;         /* Total nanoseconds spent waiting. */
+    int64_t wait_max;           /* Longest wait, in nanoseconds. */
+    int64_t hold_max;           /* Longest hold, in nanoseconds (locks). */
+    uint64_t donations;         /* Priority donations through it (locks). */
+    int last_donor;             /* Tid of the last donor, or 0. */
+    char last_donor_name[16];   /* Name of the last donor. */
+  };
+
+extern bool lockstat_enabled;
+
+struct lockstat *lockstat_register (const char *name, bool is_sema);
+int64_t lockstat_now (void);
+int64_t lockstat_acquired (struct lockstat *);
+void lockstat_waited (struct lockstat *, int64_t wait_start);
+void lockstat_released (struct lockstat *, int64_t held_since);
+void lockstat_donated (struct lockstat *, const struct thread *donor);
+void lockstat_print_stats (void);
+
+#endif /* threads/lockstat.h */
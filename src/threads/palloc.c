@@ -1,14 +1,15 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,22 +24,84 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is managed as a binary buddy system.  A block of
+   order K is 2**K pages long and starts at a page index, counted
+   from the pool's base, that is a multiple of 2**K.  Its buddy is
+   the block of the same order whose index differs only in bit K.
+   Free blocks are kept on one list per order, linked through
+   their first page, so allocating and freeing take time
+   proportional to the number of orders rather than to the size
+   of the pool.  A request for a number of pages that is not a
+   power of 2 takes the smallest block that fits and frees the
+   tail end of it again.
+
+   Each pool also keeps a reserve of pages that the idle thread
+   has zeroed ahead of time, so that most PAL_ZERO requests for a
+   single page need not zero it.  Pages in the reserve count as
+   allocated, so other requests leave them alone until the pool
+   runs out of free pages.
+
+   The pools are changed with interrupts off rather than under a
+   lock, because pages of dying threads are freed from inside the
+   scheduler.  Every operation is short. */
+
+/* Number of block orders.  The largest block is 2**(ORDER_CNT - 1)
+   pages, which is more than Pintos can address. */
+#define ORDER_CNT 16
+
+/* In a pool's `orders' array, marks the first page of a free
+   block, whose order is in the low bits. */
+#define FREE_HEAD 0x80
+
+/* Largest number of pages in a zeroed reserve. */
+#define ZERO_MAX 256
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages. */
+    uint8_t *orders;                    /* Per page: FREE_HEAD | order, or 0. */
+    struct list free_lists[ORDER_CNT];  /* Free blocks of each order. */
+    size_t free_cnt[ORDER_CNT];         /* Lengths of free_lists. */
+    unsigned free_mask;                 /* Bit K set if free_lists[K] nonempty. */
+    size_t free_pages;                  /* Number of free pages. */
+
+    /* Zeroed reserve. */
+    size_t zero_pages[ZERO_MAX];        /* Indexes of pages in the reserve. */
+    size_t zero_cnt;                    /* Number of pages in the reserve. */
+    bool zero_filling;                  /* Refilling up to the high mark? */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Size of each pool's zeroed reserve.  The idle thread starts
+   refilling a reserve when it falls below half of this, and stops
+   when it is full again.  Controlled by kernel command-line
+   option "-pzero=COUNT". */
+size_t palloc_zero_target = 32;
+
+/* Zeroed reserve statistics. */
+static long long zero_hits;     /* # of PAL_ZERO pages from a reserve. */
+static long long zero_misses;   /* # of PAL_ZERO pages zeroed on demand. */
+static long long zero_filled;   /* # of pages zeroed while idle. */
+static long long zero_reclaimed; /* # of reserve pages given back. */
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void free_block (struct pool *, size_t page_idx, unsigned order);
+static unsigned order_for (size_t page_cnt);
+static struct list_elem *block_elem (const struct pool *, size_t page_idx);
+static size_t block_index (const struct pool *, struct list_elem *);
+static size_t reclaim_reserve (struct pool *);
+static bool zero_one (struct pool *);
+static void print_pool (const struct pool *, const char *name);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -71,24 +134,52 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
   void *pages;
-  size_t page_idx;
+  size_t page_idx = SIZE_MAX;
+  bool zeroed = false;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  old_level = intr_disable ();
+  if ((flags & PAL_ZERO) && page_cnt == 1)
+    {
+      if (pool->zero_cnt > 0)
+        {
+          page_idx = pool->zero_pages[--pool->zero_cnt];
+          zero_hits++;
+          zeroed = true;
+        }
+      else
+        zero_misses++;
+    }
+  if (page_idx == SIZE_MAX)
+    page_idx = alloc_pages (pool, page_cnt);
+
+  /* Out of free pages: give back the zeroed reserve. */
+  if (page_idx == SIZE_MAX && reclaim_reserve (pool) > 0)
+    page_idx = alloc_pages (pool, page_cnt);
+  intr_set_level (old_level);
+
+  /* Under memory pressure, give back the pages cached for new
+     threads and try again. */
+  if (page_idx == SIZE_MAX && pool == &kernel_pool
+      && thread_cache_trim (0) > 0)
+    {
+      old_level = intr_disable ();
+      page_idx = alloc_pages (pool, page_cnt);
+      intr_set_level (old_level);
+    }
 
-  if (page_idx != BITMAP_ERROR)
+  if (page_idx != SIZE_MAX)
     pages = pool->base + PGSIZE * page_idx;
   else
     pages = NULL;
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -113,12 +204,37 @@ palloc_get_page (enum palloc_flags flags)
   return palloc_get_multiple (flags, 1);
 }
 
+/* Zeroes a free page for the reserve of a pool that needs it.
+   Called by the idle thread with interrupts on, so that another
+   thread that becomes ready preempts the zeroing.  Returns true
+   if it zeroed a page, false if there was nothing to do. */
+bool
+palloc_zero_idle (void)
+{
+  return zero_one (&kernel_pool) || zero_one (&user_pool);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  enum intr_level old_level = intr_disable ();
+
+  print_pool (&kernel_pool, "kernel");
+  print_pool (&user_pool, "user");
+  printf ("Page zeroing: %lld hits, %lld misses, %lld zeroed while idle, "
+          "%lld reclaimed\n",
+          zero_hits, zero_misses, zero_filled, zero_reclaimed);
+  intr_set_level (old_level);
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -132,13 +248,15 @@ palloc_free_multiple (void *pages, size_t page_cnt)
     NOT_REACHED ();
 
   page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  old_level = intr_disable ();
+  free_pages (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -153,20 +271,36 @@ palloc_free_page (void *page)
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's orders array at its base.
+     Calculate the space needed for it
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t meta_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  enum intr_level old_level;
+  unsigned order;
+  if (meta_pages > page_cnt)
+    PANIC ("Not enough memory in %s for page orders.", name);
+  page_cnt -= meta_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->orders = base;
+  memset (p->orders, 0, page_cnt);
+  p->base = (uint8_t *) base + meta_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  for (order = 0; order < ORDER_CNT; order++)
+    {
+      list_init (&p->free_lists[order]);
+      p->free_cnt[order] = 0;
+    }
+  p->free_mask = 0;
+  p->free_pages = 0;
+  p->zero_cnt = 0;
+  p->zero_filling = true;
+
+  old_level = intr_disable ();
+  free_pages (p, 0, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +310,198 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or SIZE_MAX if there is no free block big
+   enough.  Interrupts must be off. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt)
+{
+  unsigned want = order_for (page_cnt);
+  unsigned order;
+  unsigned mask;
+  size_t page_idx;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (want >= ORDER_CNT)
+    return SIZE_MAX;
+  mask = pool->free_mask & ~((1u << want) - 1);
+  if (mask == 0)
+    return SIZE_MAX;
+
+  /* Take the smallest free block that is big enough. */
+  order = __builtin_ctz (mask);
+  page_idx = block_index (pool, list_pop_front (&pool->free_lists[order]));
+  if (--pool->free_cnt[order] == 0)
+    pool->free_mask &= ~(1u << order);
+  pool->orders[page_idx] = 0;
+  pool->free_pages -= (size_t) 1 << order;
+
+  /* Split it down to the order wanted, freeing the upper halves,
+     and give back the pages beyond PAGE_CNT. */
+  while (order > want)
+    {
+      order--;
+      free_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+  if (page_cnt < (size_t) 1 << want)
+    free_pages (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+  return page_idx;
+}
+
+/* Frees the PAGE_CNT pages of POOL starting at index PAGE_IDX, as
+   the largest aligned blocks that fit.  Interrupts must be
+   off. */
+static void
+free_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (page_cnt > 0)
+    {
+      unsigned order = 0;
+      while (order + 1 < ORDER_CNT
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Frees the block of POOL of the given ORDER at PAGE_IDX,
+   merging it with its buddy for as long as the buddy is free. */
+static void
+free_block (struct pool *pool, size_t page_idx, unsigned order)
+{
+  ASSERT (page_idx % ((size_t) 1 << order) == 0);
+  ASSERT (!(pool->orders[page_idx] & FREE_HEAD));
+
+  pool->free_pages += (size_t) 1 << order;
+  while (order + 1 < ORDER_CNT)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+      if (buddy + ((size_t) 1 << order) > pool->page_cnt
+          || pool->orders[buddy] != (FREE_HEAD | order))
+        break;
+
+      list_remove (block_elem (pool, buddy));
+      if (--pool->free_cnt[order] == 0)
+        pool->free_mask &= ~(1u << order);
+      pool->orders[buddy] = 0;
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+
+  pool->orders[page_idx] = FREE_HEAD | order;
+  list_push_front (&pool->free_lists[order], block_elem (pool, page_idx));
+  pool->free_cnt[order]++;
+  pool->free_mask |= 1u << order;
+}
+
+/* Returns the order of the smallest block of at least PAGE_CNT
+   pages. */
+static unsigned
+order_for (size_t page_cnt)
+{
+  unsigned order = 0;
+
+  while (((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Returns the list element stored in the first page of POOL's
+   free block at PAGE_IDX. */
+static struct list_elem *
+block_elem (const struct pool *pool, size_t page_idx)
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the index in POOL of the free block whose list element
+   is E. */
+static size_t
+block_index (const struct pool *pool, struct list_elem *e)
+{
+  return ((uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Gives the pages in POOL's zeroed reserve back to its free
+   pages.  Interrupts must be off.  Returns the number of pages
+   given back. */
+static size_t
+reclaim_reserve (struct pool *pool)
+{
+  size_t cnt = pool->zero_cnt;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (pool->zero_cnt > 0)
+    free_block (pool, pool->zero_pages[--pool->zero_cnt], 0);
+  zero_reclaimed += cnt;
+  return cnt;
+}
+
+/* Adds a page to POOL's zeroed reserve if it is below its low
+   watermark, or is being refilled and not yet full.  Returns true
+   if it zeroed a page, false otherwise.  The page is allocated
+   before it is zeroed, with interrupts on, so nothing else can
+   take it meanwhile. */
+static bool
+zero_one (struct pool *pool)
+{
+  size_t target = palloc_zero_target < ZERO_MAX ? palloc_zero_target : ZERO_MAX;
+  enum intr_level old_level = intr_disable ();
+  size_t page_idx = SIZE_MAX;
+
+  if (pool->zero_cnt >= target)
+    pool->zero_filling = false;
+  else if (pool->zero_cnt < target / 2)
+    pool->zero_filling = true;
+  if (pool->zero_filling)
+    page_idx = alloc_pages (pool, 1);
+  intr_set_level (old_level);
+
+  if (page_idx == SIZE_MAX)
+    return false;
+
+  memset (pool->base + PGSIZE * page_idx, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  zero_filled++;
+  if (pool->zero_cnt < ZERO_MAX)
+    pool->zero_pages[pool->zero_cnt++] = page_idx;
+  else
+    free_block (pool, page_idx, 0);
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Prints the free blocks of POOL, named NAME, by order, as a
+   measure of its fragmentation.  Interrupts must be off. */
+static void
+print_pool (const struct pool *pool, const char *name)
+{
+  int largest = -1;
+  unsigned order;
+
+  for (order = 0; order < ORDER_CNT; order++)
+    if (pool->free_cnt[order] > 0)
+      largest = order;
+
+  printf ("Page pool %s: %zu of %zu pages free, largest block %zu pages,"
+          " free blocks by order:",
+          name, pool->free_pages, pool->page_cnt,
+          largest >= 0 ? (size_t) 1 << largest : 0);
+  for (order = 0; (int) order <= largest; order++)
+    printf (" %zu", pool->free_cnt[order]);
+  printf ("\n");
+}
@@ -0,0 +1,297 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches, after Bonwick's slab allocator.
+
+   A cache hands out objects of one exact size, rounded up only to
+   OBJ_ALIGN, where malloc() would round up to a power of 2.  It
+   carves them out of "slabs", each one page from the page
+   allocator with a struct slab at its start, and keeps each slab
+   on one of three lists: full, partial, or empty.  Objects are
+   allocated from partial slabs first, so that slabs fill up and
+   empty ones can be given back.  A cache keeps one empty slab to
+   absorb alloc/free churn and frees the rest.
+
+   If a cache has a constructor, it runs once for each object
+   when its slab is created, not on every allocation, so objects
+   must be freed in their constructed state.  The free list link
+   is then stored after the object, so as not to disturb it.
+
+   The space left over in a slab after its objects is used to
+   "color" it: each new slab's objects start one cache line
+   further in than the last one's, up to the leftover space, so
+   that objects at the same index in different slabs do not all
+   map to the same cache lines. */
+
+/* Alignment of objects. */
+#define OBJ_ALIGN sizeof (void *)
+
+/* Cache line size assumed for coloring. */
+#define CACHE_LINE 32
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* An object cache. */
+struct kmem_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Object size requested. */
+    size_t stride;              /* Distance between objects. */
+    size_t link_ofs;            /* Offset of free list link in object. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    size_t color_max;           /* Largest color offset. */
+    size_t color_next;          /* Color offset for the next slab. */
+    kmem_ctor_func *ctor;       /* Constructor, or null. */
+    struct list_elem elem;      /* Element in `caches'. */
+
+    /* LOCK protects the members below. */
+    struct lock lock;
+    struct list full;           /* Slabs with no free objects. */
+    struct list partial;        /* Slabs with some free objects. */
+    struct list empty;          /* Slabs with no objects in use. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Number of slabs. */
+    size_t in_use;              /* Number of objects allocated. */
+    long long allocs;           /* # of kmem_cache_alloc() calls. */
+    long long frees;            /* # of kmem_cache_free() calls. */
+    long long slabs_created;    /* # of slabs obtained from palloc. */
+  };
+
+/* A slab, at the start of its page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in a cache's slab list. */
+    void *free;                 /* First free object, or null. */
+    size_t in_use;              /* Number of objects allocated. */
+  };
+
+/* All caches, for statistics.  Caches are never destroyed. */
+static struct list caches = LIST_INITIALIZER (caches);
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+static void **link_of (struct kmem_cache *, void *obj);
+
+/* Creates and returns a cache of SIZE-byte objects called NAME.
+   If CTOR is non-null, it is called on each object when its slab
+   is created.  Panics if memory is short, since caches are
+   created during initialization. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor_func *ctor)
+{
+  struct kmem_cache *c;
+  size_t space;
+
+  ASSERT (size > 0);
+
+  c = malloc (sizeof *c);
+  if (c == NULL)
+    PANIC ("kmem_cache_create: out of memory");
+
+  c->name = name;
+  c->obj_size = size;
+  c->ctor = ctor;
+  if (ctor != NULL)
+    {
+      c->link_ofs = ROUND_UP (size, sizeof (void *));
+      c->stride = ROUND_UP (c->link_ofs + sizeof (void *), OBJ_ALIGN);
+    }
+  else
+    {
+      c->link_ofs = 0;
+      c->stride = ROUND_UP (size < sizeof (void *) ? sizeof (void *) : size,
+                            OBJ_ALIGN);
+    }
+
+  space = PGSIZE - ROUND_UP (sizeof (struct slab), OBJ_ALIGN);
+  c->objs_per_slab = space / c->stride;
+  if (c->objs_per_slab == 0)
+    PANIC ("kmem_cache_create: %zu-byte objects do not fit in a slab", size);
+  c->color_max = ROUND_DOWN (space - c->objs_per_slab * c->stride,
+                             CACHE_LINE);
+  c->color_next = 0;
+
+  lock_init (&c->lock);
+  list_init (&c->full);
+  list_init (&c->partial);
+  list_init (&c->empty);
+  c->slab_cnt = 0;
+  c->in_use = 0;
+  c->allocs = 0;
+  c->frees = 0;
+  c->slabs_created = 0;
+  list_push_back (&caches, &c->elem);
+  return c;
+}
+
+/* Allocates and returns an object from cache C, or returns a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      if (!list_empty (&c->empty))
+        s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      else
+        {
+          s = slab_create (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  obj = s->free;
+  s->free = *link_of (c, obj);
+  if (++s->in_use == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  c->in_use++;
+  c->allocs++;
+  lock_release (&c->lock);
+  return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+  s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it must stay constructed. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->stride);
+#endif
+
+  lock_acquire (&c->lock);
+  *link_of (c, obj) = s->free;
+  s->free = obj;
+  if (s->in_use-- == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  else if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (list_empty (&c->empty))
+        list_push_front (&c->empty, &s->elem);
+      else
+        {
+          s->magic = 0;
+          c->slab_cnt--;
+          palloc_free_page (s);
+        }
+    }
+  c->in_use--;
+  c->frees++;
+  lock_release (&c->lock);
+}
+
+/* Prints statistics for each cache. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      printf ("kmem_cache %s: %zu-byte objects, %zu per slab, %zu in use, "
+              "%zu slabs, %lld allocs, %lld frees, %lld slabs created\n",
+              c->name, c->obj_size, c->objs_per_slab, c->in_use,
+              c->slab_cnt, c->allocs, c->frees, c->slabs_created);
+    }
+}
+
+/* Creates a new slab for cache C, whose lock must be held, with
+   all its objects free.  Returns the slab, or a null pointer if
+   memory is not available. */
+static struct slab *
+slab_create (struct kmem_cache *c)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+
+  /* Lay out the objects at the next color, last to first, so
+     that the free list hands them out in address order. */
+  obj = ((uint8_t *) s + ROUND_UP (sizeof *s, OBJ_ALIGN) + c->color_next);
+  c->color_next += CACHE_LINE;
+  if (c->color_next > c->color_max)
+    c->color_next = 0;
+
+  s->free = NULL;
+  for (i = c->objs_per_slab; i-- > 0; )
+    {
+      void *o = obj + i * c->stride;
+      if (c->ctor != NULL)
+        c->ctor (o);
+      *link_of (c, o) = s->free;
+      s->free = o;
+    }
+
+  c->slab_cnt++;
+  c->slabs_created++;
+  return s;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  return s;
+}
+
+/* Returns the location of the free list link in OBJ, an object of
+   cache C. */
+static void **
+link_of (struct kmem_cache *c, void *obj)
+{
+  return (void **) ((uint8_t *) obj + c->link_ofs);
+}
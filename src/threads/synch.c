@@ -31,8 +31,119 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 
+static void yield_if_outranked (struct thread *);
+
+/* Orders threads in a wait queue: by priority, then by arrival,
+   so that a thread that arrived earlier compares greater. */
+static bool
+waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+             void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, wait_elem);
+  const struct thread *b = heap_entry (b_, struct thread, wait_elem);
+
+  if (a->priority != b->priority)
+    return a->priority < b->priority;
+  return (int) (a->wait_seq - b->wait_seq) > 0;
+}
+
+/* Initializes WQ as an empty wait queue. */
+void
+waitq_init (struct waitq *wq)
+{
+  ASSERT (wq != NULL);
+
+  heap_init (&wq->waiters, waiter_less, NULL);
+  wq->next_seq = 0;
+}
+
+/* Returns true if no threads are waiting on WQ. */
+bool
+waitq_empty (const struct waitq *wq)
+{
+  return heap_empty (&wq->waiters);
+}
+
+/* Returns the thread that waitq_wake() would wake next, or a
+   null pointer if WQ is empty. */
+struct thread *
+waitq_front (const struct waitq *wq)
+{
+  struct heap_elem *e = heap_max (&wq->waiters);
+  return e != NULL ? heap_entry (e, struct thread, wait_elem) : NULL;
+}
+
+/* Adds T, which must not already be waiting, to WQ.  T should
+   block soon afterward, before interrupts are turned back on.
+   Interrupts must be off. */
+void
+waitq_insert (struct waitq *wq, struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->waitq == NULL);
+
+  t->waitq = wq;
+  t->wait_seq = wq->next_seq++;
+  heap_insert (&wq->waiters, &t->wait_elem);
+}
+
+/* Adds the running thread to WQ and blocks it until it is woken
+   by waitq_wake().  Interrupts must be off. */
+void
+waitq_wait (struct waitq *wq)
+{
+  ASSERT (!intr_context ());
+
+  waitq_insert (wq, thread_current ());
+  thread_block ();
+}
+
+/* Removes the highest-priority thread from WQ, unblocks it, and
+   returns it, or returns a null pointer if WQ is empty.  Does
+   not yield.  Interrupts must be off. */
+struct thread *
+waitq_wake (struct waitq *wq)
+{
+  struct thread *t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (heap_empty (&wq->waiters))
+    return NULL;
+  t = heap_entry (heap_pop_max (&wq->waiters), struct thread, wait_elem);
+  t->waitq = NULL;
+  thread_unblock (t);
+  return t;
+}
+
+/* Repositions T in the wait queue it is waiting on after its
+   priority has changed.  Does nothing if T is not waiting.
+   Interrupts must be off. */
+void
+waitq_reorder (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->waitq != NULL)
+    heap_update (&t->waitq->waiters, &t->wait_elem);
+}
+
+/* Yields the CPU if a ready thread, such as WOKEN, should run in
+   place of the running thread, whose priority may also just have
+   dropped.  In an interrupt handler, where only WOKEN can have
+   changed the picture, arranges to yield on return instead. */
+static void
+yield_if_outranked (struct thread *woken)
+{
+  if (!intr_context ())
+    check_priority ();
+  else if (thread_preempts (woken))
+    intr_yield_on_return ();
+}
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -43,14 +154,27 @@
    - up or "V": increment the value (and wake up one waiting
      thread, if any). */
 void
-sema_init (struct semaphore *sema, unsigned value) 
+(sema_init) (struct semaphore *sema, unsigned value) 
 {
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  waitq_init (&sema->waiters);
+#ifdef LOCKSTAT
+  sema->stat = NULL;
+#endif
 }
 
+#ifdef LOCKSTAT
+/* Like sema_init(), but counts contention for SEMA under NAME. */
+void
+sema_init_named (struct semaphore *sema, unsigned value, const char *name)
+{
+  (sema_init) (sema, value);
+  sema->stat = lockstat_register (name, true);
+}
+#endif
+
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
    to become positive and then atomically decrements it.
 
@@ -62,6 +186,9 @@ void
 sema_down (struct semaphore *sema) 
 {
   enum intr_level old_level;
+#ifdef LOCKSTAT
+  int64_t wait_start = 0;
+#endif
 
   ASSERT (sema != NULL);
   ASSERT (!intr_context ());
@@ -69,13 +196,18 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      // ---Solutie---
-      list_insert_ordered(&sema->waiters, &thread_current ()->elem, 
-        (list_less_func *)cmp_priority, NULL);
-
-      thread_block ();
+#ifdef LOCKSTAT
+      if (wait_start == 0)
+        wait_start = lockstat_now ();
+#endif
+      TRACE (TRACE_BLOCK, thread_current ()->tid, 0, TRACE_REASON_SEMA);
+      waitq_wait (&sema->waiters);
     }
   sema->value--;
+#ifdef LOCKSTAT
+  lockstat_acquired (sema->stat);
+  lockstat_waited (sema->stat, wait_start);
+#endif
   intr_set_level (old_level);
 }
 
@@ -97,6 +229,9 @@ sema_try_down (struct semaphore *sema)
     {
       sema->value--;
       success = true; 
+#ifdef LOCKSTAT
+      lockstat_acquired (sema->stat);
+#endif
     }
   else
     success = false;
@@ -106,30 +241,26 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up one thread of those waiting for SEMA, if any,
+   yielding to it if it has a higher priority than the running
+   thread.
 
    This function may be called from an interrupt handler. */
 void
 sema_up (struct semaphore *sema) 
 {
+  struct thread *woken;
   enum intr_level old_level;
 
   ASSERT (sema != NULL);
 
   old_level = intr_disable ();
-
-  if (!list_empty (&sema->waiters)) {
-
-    // ---Solutie---
-    list_sort(&sema->waiters, (list_less_func *)cmp_priority, NULL);
-
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
-  }
-
+  woken = waitq_wake (&sema->waiters);
+  if (woken != NULL)
+    TRACE (TRACE_SEMA_UP, thread_current ()->tid, woken->tid, 0);
   sema->value++;
+  yield_if_outranked (woken);
   intr_set_level (old_level);
-
 }
 
 static void sema_test_helper (void *sema_);
@@ -168,30 +299,49 @@ sema_test_helper (void *sema_)
       sema_up (&sema[1]);
     }
 }
-
+
+static void lock_take (struct lock *);
+static struct thread *lock_drop (struct lock *);
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
    try to acquire that lock.
 
-   A lock is a specialization of a semaphore with an initial
-   value of 1.  The difference between a lock and such a
-   semaphore is twofold.  First, a semaphore can have a value
-   greater than 1, but a lock can only be owned by a single
-   thread at a time.  Second, a semaphore does not have an owner,
-   meaning that one thread can "down" the semaphore and then
-   another one "up" it, but with a lock the same thread must both
-   acquire and release it.  When these restrictions prove
-   onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   A lock is like a semaphore with an initial value of 1.  The
+   difference between a lock and such a semaphore is twofold.
+   First, a semaphore can have a value greater than 1, but a lock
+   can only be owned by a single thread at a time.  Second, a
+   semaphore does not have an owner, meaning that one thread can
+   "down" the semaphore and then another one "up" it, but with a
+   lock the same thread must both acquire and release it.  When
+   these restrictions prove onerous, it's a good sign that a
+   semaphore should be used, instead of a lock.
+
+   Because a lock has an owner, threads waiting for it donate
+   their priority to the owner. */
 void
-lock_init (struct lock *lock)
+(lock_init) (struct lock *lock)
 {
   ASSERT (lock != NULL);
 
   lock->holder = NULL;
-  sema_init (&lock->semaphore, 1);
+  waitq_init (&lock->waiters);
+#ifdef LOCKSTAT
+  lock->stat = NULL;
+  lock->held_since = 0;
+#endif
+}
+
+#ifdef LOCKSTAT
+/* Like lock_init(), but counts contention for LOCK under NAME. */
+void
+lock_init_named (struct lock *lock, const char *name)
+{
+  (lock_init) (lock);
+  lock->stat = lockstat_register (name, false);
 }
+#endif
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
@@ -204,26 +354,48 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+#ifdef LOCKSTAT
+  int64_t wait_start = 0;
+#endif
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
-  // ---Solutie---
-  if (!thread_mlfqs && lock->holder != NULL) {
-
-    thread_current()->locked_by = lock;
-    list_insert_ordered(&lock->holder->threads_locked,
-      &thread_current()->donate_elem, (list_less_func *) &cmp_donate, NULL);
-    donation_acquire();
-
-  }
-
-  sema_down (&lock->semaphore);
-
-  // ---Solutie---
-  thread_current()->locked_by = NULL;
-
-  lock->holder = thread_current ();
+  old_level = intr_disable ();
+  while (lock->holder != NULL)
+    {
+#ifdef LOCKSTAT
+      if (wait_start == 0)
+        wait_start = lockstat_now ();
+#endif
+      TRACE (TRACE_BLOCK, cur->tid, lock->holder->tid, TRACE_REASON_LOCK);
+      waitq_insert (&lock->waiters, cur);
+      if (!thread_mlfqs)
+        {
+          /* Donate our priority to the holder, and on down the
+             chain of locks that it is waiting for. */
+          cur->waiting_lock = lock;
+          if (lock->holder->priority < cur->priority)
+            {
+              TRACE (TRACE_DONATE, cur->tid, lock->holder->tid,
+                     cur->priority);
+#ifdef LOCKSTAT
+              lockstat_donated (lock->stat, cur);
+#endif
+            }
+          thread_update_priority (lock->holder);
+        }
+      thread_block ();
+    }
+  cur->waiting_lock = NULL;
+  lock_take (lock);
+#ifdef LOCKSTAT
+  lockstat_waited (lock->stat, wait_start);
+#endif
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -235,17 +407,39 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
-  success = sema_try_down (&lock->semaphore);
+  old_level = intr_disable ();
+  success = lock->holder == NULL;
   if (success)
-    lock->holder = thread_current ();
+    lock_take (lock);
+  intr_set_level (old_level);
   return success;
 }
 
+/* Makes the running thread the holder of LOCK, which must be
+   free, and takes on the priorities of any threads waiting for
+   it.  Interrupts must be off. */
+static void
+lock_take (struct lock *lock)
+{
+  struct thread *cur = thread_current ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (lock->holder == NULL);
+
+  lock->holder = cur;
+  list_push_back (&cur->held_locks, &lock->elem);
+  thread_update_priority (cur);
+#ifdef LOCKSTAT
+  lock->held_since = lockstat_acquired (lock->stat);
+#endif
+}
+
 /* Releases LOCK, which must be owned by the current thread.
 
    An interrupt handler cannot acquire a lock, so it does not
@@ -254,27 +448,42 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
-  // ---Solutie---
-  if (!thread_mlfqs) 
-  {
-    struct list_elem *e = list_begin(&thread_current()->threads_locked);
-    while (e != list_end(&thread_current()->threads_locked))
-    {
-      struct thread *t = list_entry(e, struct thread, donate_elem);
-      struct list_elem *tmp = list_next(e);
-      if (lock == t->locked_by) list_remove(e);
-      e = tmp;
-    }
+  old_level = intr_disable ();
+  yield_if_outranked (lock_drop (lock));
+  intr_set_level (old_level);
+}
 
-    donation_release();
-  }
+/* Releases LOCK, which must be owned by the current thread, and
+   wakes up its highest-priority waiter, if any, without
+   yielding.  Returns the thread woken, or a null pointer.
+   Interrupts must be off. */
+static struct thread *
+lock_drop (struct lock *lock)
+{
+  struct thread *cur = thread_current ();
+  struct thread *woken;
 
-  lock->holder = NULL;
-  sema_up (&lock->semaphore);
+  ASSERT (intr_get_level () == INTR_OFF);
 
+  /* Give up the priority donated through LOCK before waking its
+     next holder, so that we yield to it if we should. */
+  lock->holder = NULL;
+  list_remove (&lock->elem);
+  thread_update_priority (cur);
+#ifdef LOCKSTAT
+  lockstat_released (lock->stat, lock->held_since);
+  lock->held_since = 0;
+#endif
+
+  woken = waitq_wake (&lock->waiters);
+  if (woken != NULL)
+    TRACE (TRACE_SEMA_UP, cur->tid, woken->tid, 0);
+  return woken;
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -287,26 +496,171 @@ lock_held_by_current_thread (const struct lock *lock)
 
   return lock->holder == thread_current ();
 }
-
-/* One semaphore in a list. */
-struct semaphore_elem 
-  {
-    struct list_elem elem;              /* List element. */
-    struct semaphore semaphore;         /* This semaphore. */
-    // ---Solutie---
-    struct thread* holder;
-  };
-
-// ---Solutie---
-bool 
-cmp_sema(const struct list_elem *a,
-  const struct list_elem *b,
-  void *axu)
-{
-  struct semaphore_elem *left = list_entry(a, struct  semaphore_elem, elem);
-  struct semaphore_elem *right = list_entry(b, struct  semaphore_elem, elem);
-  
-  return left->holder->priority > right->holder->priority;
+
+static struct rw_hold *rw_hold_find (struct thread *, struct rwlock *);
+static void rw_wait (struct rwlock *, struct waitq *);
+static void rw_take (struct rwlock *, struct thread *, bool writing);
+
+/* Initializes RW as an unheld readers-writer lock.  Threads that
+   block on RW donate their priority to all of its holders.
+   Rwlocks are not recursive: it is an error for a thread to
+   acquire an rwlock that it already holds. */
+void
+rw_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  rw->writing = false;
+  list_init (&rw->holders);
+  waitq_init (&rw->readers);
+  waitq_init (&rw->writers);
+}
+
+/* Acquires RW for reading, sleeping while it is held for writing
+   or while a writer is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw_hold_find (cur, rw) == NULL);
+
+  old_level = intr_disable ();
+  if (rw->writing || !waitq_empty (&rw->writers))
+    {
+      /* rw_release() makes us a holder before waking us. */
+      rw_wait (rw, &rw->readers);
+      ASSERT (rw_hold_find (cur, rw) != NULL);
+    }
+  else
+    rw_take (rw, cur, false);
+  intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping while anyone holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw_hold_find (cur, rw) == NULL);
+
+  old_level = intr_disable ();
+  if (!list_empty (&rw->holders))
+    {
+      /* rw_release() makes us the holder before waking us. */
+      rw_wait (rw, &rw->writers);
+      ASSERT (rw->writing && rw_hold_find (cur, rw) != NULL);
+    }
+  else
+    rw_take (rw, cur, true);
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading or
+   writing.  When the last holder lets go, hands RW to one waiting
+   writer if there is any, otherwise to all waiting readers.  The
+   threads woken already hold RW, so no thread that arrives before
+   they run can take it from under them. */
+void
+rw_release (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  struct rw_hold *hold;
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  hold = rw_hold_find (cur, rw);
+  ASSERT (hold != NULL);
+
+  old_level = intr_disable ();
+  list_remove (&hold->elem);
+  hold->rwlock = NULL;
+  rw->writing = false;
+  thread_update_priority (cur);
+
+  if (list_empty (&rw->holders))
+    {
+      struct thread *t = waitq_wake (&rw->writers);
+      if (t != NULL)
+        rw_take (rw, t, true);
+      else
+        while ((t = waitq_wake (&rw->readers)) != NULL)
+          rw_take (rw, t, false);
+    }
+  yield_if_outranked (NULL);
+  intr_set_level (old_level);
+}
+
+/* Returns T's hold on RW, or if RW is null, an unused hold slot.
+   Returns a null pointer if there is none. */
+static struct rw_hold *
+rw_hold_find (struct thread *t, struct rwlock *rw)
+{
+  int i;
+
+  for (i = 0; i < RW_HOLD_CNT; i++)
+    if (t->rw_holds[i].rwlock == rw)
+      return &t->rw_holds[i];
+  return NULL;
+}
+
+/* Blocks the running thread on WQ, one of RW's wait queues,
+   donating its priority to RW's holders.  Interrupts must be
+   off. */
+static void
+rw_wait (struct rwlock *rw, struct waitq *wq)
+{
+  struct thread *cur = thread_current ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  TRACE (TRACE_BLOCK, cur->tid, 0, TRACE_REASON_RWLOCK);
+  waitq_insert (wq, cur);
+  if (!thread_mlfqs)
+    {
+      struct list_elem *e;
+
+      cur->waiting_rwlock = rw;
+      for (e = list_begin (&rw->holders); e != list_end (&rw->holders);
+           e = list_next (e))
+        thread_update_priority (list_entry (e, struct rw_hold, elem)->thread);
+    }
+  thread_block ();
+}
+
+/* Records T, which is either the running thread or one just
+   woken from RW's wait queues, as a holder of RW, for writing if
+   WRITING is true.  T takes on the priorities of any threads
+   waiting for RW.  Interrupts must be off. */
+static void
+rw_take (struct rwlock *rw, struct thread *t, bool writing)
+{
+  struct rw_hold *hold = rw_hold_find (t, NULL);
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->waitq == NULL);
+
+  if (hold == NULL)
+    PANIC ("%s: holding more than %d rwlocks", t->name, RW_HOLD_CNT);
+  hold->rwlock = rw;
+  hold->thread = t;
+  list_push_back (&rw->holders, &hold->elem);
+  rw->writing = writing;
+  t->waiting_rwlock = NULL;
+  thread_update_priority (t);
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -317,7 +671,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  waitq_init (&cond->waiters);
 }
  
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -343,28 +697,29 @@ cond_init (struct condition *cond)
 void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
-  struct semaphore_elem waiter;
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
   
-  sema_init (&waiter.semaphore, 0);
-  // list_push_back (&cond->waiters, &waiter.elem);
-  // ---Solutie---
-  waiter.holder = thread_current();
-  list_insert_ordered(&cond->waiters, &waiter.elem, 
-        (list_less_func *)cmp_sema, NULL);
-
-  lock_release (lock);
-  sema_down (&waiter.semaphore);
+  /* Queue up and release LOCK without yielding, so that nobody
+     can signal COND before we are blocked on it. */
+  old_level = intr_disable ();
+  TRACE (TRACE_BLOCK, thread_current ()->tid, 0, TRACE_REASON_COND);
+  waitq_insert (&cond->waiters, thread_current ());
+  lock_drop (lock);
+  thread_block ();
+  intr_set_level (old_level);
+
   lock_acquire (lock);
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
-   LOCK must be held before calling this function.
+   this function signals the highest-priority one to wake up
+   from its wait.  LOCK must be held before calling this
+   function.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
@@ -372,18 +727,16 @@ cond_wait (struct condition *cond, struct lock *lock)
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) 
 {
+  enum intr_level old_level;
+
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) {
-    // ---Solutie---
-    list_sort(&cond->waiters, (list_less_func *)cmp_sema, NULL);
-
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
-  }
+  old_level = intr_disable ();
+  yield_if_outranked (waitq_wake (&cond->waiters));
+  intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -398,6 +751,6 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!waitq_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
@@ -1,14 +1,41 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#ifdef LOCKSTAT
+#include "threads/lockstat.h"
+#endif
+
+struct thread;
+
+/* Priority wait queue.  Threads are woken highest priority
+   first, and in arrival order among equal priorities.  A thread
+   waits on at most one queue at a time. */
+struct waitq
+  {
+    struct heap waiters;        /* Waiting threads. */
+    unsigned next_seq;          /* Arrival stamp for next waiter. */
+  };
+
+void waitq_init (struct waitq *);
+bool waitq_empty (const struct waitq *);
+struct thread *waitq_front (const struct waitq *);
+void waitq_insert (struct waitq *, struct thread *);
+void waitq_wait (struct waitq *);
+struct thread *waitq_wake (struct waitq *);
+void waitq_reorder (struct thread *);
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct waitq waiters;       /* Waiting threads. */
+#ifdef LOCKSTAT
+    struct lockstat *stat;      /* Contention statistics. */
+#endif
   };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,8 +47,13 @@ void sema_self_test (void);
 /* Lock. */
 struct lock
   {
-    struct thread *holder;      /* Thread holding lock (for debugging). */
-    struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct thread *holder;      /* Thread holding lock, or null. */
+    struct waitq waiters;       /* Threads waiting to acquire it. */
+    struct list_elem elem;      /* Element in holder's held_locks. */
+#ifdef LOCKSTAT
+    struct lockstat *stat;      /* Contention statistics. */
+    int64_t held_since;         /* lockstat_acquired() time, or 0. */
+#endif
   };
 
 void lock_init (struct lock *);
@@ -30,10 +62,48 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+#ifdef LOCKSTAT
+/* Name each lock and semaphore after where it is initialized. */
+void sema_init_named (struct semaphore *, unsigned value, const char *);
+void lock_init_named (struct lock *, const char *);
+#define sema_init(SEMA, VALUE) \
+        sema_init_named (SEMA, VALUE, __FILE__ ":" #SEMA)
+#define lock_init(LOCK) lock_init_named (LOCK, __FILE__ ":" #LOCK)
+#endif
+
+/* Readers-writer lock.  Any number of threads may hold it for
+   reading at once, or a single thread for writing.  Once a
+   writer is waiting, new readers wait behind it, so a stream of
+   readers cannot starve writers. */
+struct rwlock
+  {
+    bool writing;               /* Held for writing? */
+    struct list holders;        /* struct rw_holds of holding threads. */
+    struct waitq readers;       /* Threads waiting to read. */
+    struct waitq writers;       /* Threads waiting to write. */
+  };
+
+/* One thread's hold on a struct rwlock.  Each thread has
+   RW_HOLD_CNT of these, which limits the number of rwlocks it
+   can hold at once. */
+struct rw_hold
+  {
+    struct rwlock *rwlock;      /* Lock held, or null if unused. */
+    struct thread *thread;      /* Holding thread. */
+    struct list_elem elem;      /* Element in rwlock's holders. */
+  };
+
+#define RW_HOLD_CNT 4
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_release (struct rwlock *);
+
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct waitq waiters;       /* Waiting threads. */
   };
 
 void cond_init (struct condition *);
@@ -11,7 +11,9 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 
 // add
 #include "threads/fixed-point.h"
@@ -20,20 +22,32 @@
 #include "userprog/process.h"
 #endif
 
-// ---Solutie---
-static const int DEPTH = 8;
-
 /* Random value for struct thread's `magic' member.
    Used to detect stack overflow.  See the big comment at the top
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-/* List of processes in THREAD_BLOCK state, that is, processes
-   that are blocked. */
-static struct list block_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO
+   queue per priority level, and bit P of ready_mask is set
+   exactly when ready_queues[P] is nonempty, so the highest
+   ready priority is found with a single bit scan. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static unsigned ready_cnt;      /* # of threads in ready_queues, edf_ready. */
+
+/* Ready threads in the earliest-deadline-first class, earliest
+   absolute deadline on top.  These always run ahead of the
+   threads in ready_queues. */
+static struct heap edf_ready;
+
+/* CPU bandwidth reserved by EDF threads, the sum of their
+   runtime / deadline ratios, scaled by 1 << EDF_BW_SHIFT.
+   Admission control keeps it at or below EDF_BW_MAX, leaving
+   some CPU time for threads scheduled by priority. */
+#define EDF_BW_SHIFT 20
+#define EDF_BW_MAX ((95 << EDF_BW_SHIFT) / 100)
+static int64_t edf_bandwidth;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -47,6 +61,25 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+/* Pages of exited threads, kept for reuse by thread_create() so
+   that thread churn bypasses the page allocator.  Linked through
+   the dead threads' `elem' members.  Only the `struct thread' at
+   the bottom of a reused page is cleared; the stack above it is
+   left as is, since a new thread never reads stack it has not
+   written. */
+static struct list thread_cache;
+static size_t thread_cache_cnt;         /* # of pages in thread_cache. */
+static long long thread_cache_hits;     /* # of creates served from cache. */
+static long long thread_cache_misses;   /* # of creates that used palloc. */
+
+/* Maximum number of pages kept in thread_cache.  Controlled by
+   kernel command-line option "-tcache=COUNT". */
+size_t thread_cache_max = 32;
+
+/* Print per-thread resource usage?  Controlled by kernel
+   command-line option "-stats". */
+bool thread_stats;
+
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
   {
@@ -69,8 +102,18 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
-// add
-fixed_point load_avg;
+/* System load average, as used by the MLFQS scheduler. */
+static fixed_point load_avg;
+
+/* Seconds elapsed since boot, counted by the MLFQS scheduler.
+   load_avg_history[S % LOAD_AVG_HISTORY] holds the load average
+   computed at second S, for the most recent LOAD_AVG_HISTORY
+   seconds.  Blocked threads do not take part in the once-per-
+   second recent_cpu update; instead, the missed decay steps are
+   replayed from this history when they are unblocked. */
+#define LOAD_AVG_HISTORY 32
+static unsigned mlfqs_seconds;
+static fixed_point load_avg_history[LOAD_AVG_HISTORY];
 
 static void kernel_thread (thread_func *, void *aux);
 
@@ -84,77 +127,32 @@ static void schedule (void);
 void thread_schedule_tail (struct thread *prev); 
 static tid_t allocate_tid (void);
 
-// ---Solutie---
-void print_list(const struct list *list) 
-{
-  ASSERT(list != NULL);
-
-  printf("print list:");
-  struct list_elem *e;
-
-  for (e = list_begin (list); e != list_end (list); e = list_next (e))
-  {
-    struct thread *t = list_entry (e, struct thread, donate_elem);
-    // printf("%s %d\t", t->name, t->sleep_until);
-    printf("%d \n", t->priority);
-  }
-  printf("\n");
-}
-
-// ---Solutie---
-bool 
-cmp_priority (const struct list_elem *a, 
-  const struct list_elem *b, 
-  void *aux) 
-{
-  struct thread *left = list_entry(a, struct thread, elem);
-  struct thread *right = list_entry(b, struct thread, elem);
-  return left->priority > right->priority;
-}
-
-// ---Solutie---
-bool 
-cmp_donate (const struct list_elem *a, 
-  const struct list_elem *b, 
-  void *aux) 
-{
-  struct thread *left = list_entry(a, struct thread, donate_elem);
-  struct thread *right = list_entry(b, struct thread, donate_elem);
-  return left->priority > right->priority;
-}
-
-// ---Solutie---
-bool 
-cmp_sleep_until (const struct list_elem *a, 
-  const struct list_elem *b, 
-  void *aux) 
-{
-  struct thread *left = list_entry(a, struct thread, elem);
-  struct thread *right = list_entry(b, struct thread, elem);
-  return left->sleep_until < right->sleep_until;
-}
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static struct thread *ready_queue_pop (void);
+static int ready_queue_max_priority (void);
+static struct thread *ready_queue_front (void);
+static bool outranks (const struct thread *, const struct thread *);
+static heap_less_func edf_less;
+static timer_func edf_release;
+static int64_t edf_thread_bandwidth (const struct thread *);
+static void edf_leave (struct thread *);
+static void thread_set_effective_priority (struct thread *, int priority);
+static struct thread *thread_cache_get (void);
+static void thread_cache_put (struct thread *);
+
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_catch_up (struct thread *);
 
 // ---Solutie---
 void check_priority(void) {
 
-  if (!list_empty(&ready_list)) {
-    struct thread * next_thread = 
-      list_entry(list_begin(&ready_list), struct thread, elem);
-
-      // printf("check_priority %d\n", next_thread->priority);
-
-    if (thread_current()->priority < next_thread->priority) {
-      // thread_yield();
-      thread_yield__(thread_current());
-      // printf("check_priority %d\n", thread_current()->priority);
-    }
-      
+  if (thread_preempts (ready_queue_front ())) {
+    // thread_yield();
+    thread_yield__(thread_current());
   }
 }
 
-// static bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
-// static bool cmp_sleep_until (const struct list_elem *a, const struct list_elem *b, void *aux);
-
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
    general and it is possible in this case only because loader.S
@@ -177,9 +175,14 @@ thread_init (void)
   // printf("thread_init begin\n");
   ASSERT (intr_get_level () == INTR_OFF);
 
+  int pri;
+
   lock_init (&tid_lock);
-  list_init (&ready_list);
-  list_init (&block_list);
+  list_init (&thread_cache);
+  for (pri = PRI_MIN; pri <= PRI_MAX; pri++)
+    list_init (&ready_queues[pri]);
+  ready_mask = 0;
+  heap_init (&edf_ready, edf_less, NULL);
   list_init (&all_list);
 
   /* Set up a thread structure for the running thread. */
@@ -208,47 +211,43 @@ thread_start (void)
   sema_down (&idle_started);
 }
 
-// ---Solutie---
-void check_block_list(int64_t current_ticks) {
-  // check block_list and wake up unsleep threads
-  struct list_elem *e = list_begin(&block_list);
-  while (e != list_end(&block_list))
-  {
-    struct thread *t = list_entry(e, struct thread, elem);      
-    
-    if (current_ticks < t->sleep_until) break;
- 
-    list_remove(e);
-    thread_unblock(t);
-    e = list_begin(&block_list);
-    // printf("delete %s status %d from list ", t->name, t->status);
-    // print_list(&block_list);
-  }
-}
-
-
 /* Called by the timer interrupt handler at each timer tick.
-   Thus, this function runs in an external interrupt context. */
+   Thus, this function runs in an external interrupt context.
+   F is the interrupted frame, or a null pointer for a tick that
+   passed while the CPU was halted.  The tick is charged as user
+   time only if F was running in user mode, so time spent in a
+   system call or page fault counts as kernel time. */
 void
-thread_tick (int64_t current_ticks) 
+thread_tick (struct intr_frame *f) 
 {
   struct thread *t = thread_current ();
 
   /* Update statistics. */
   if (t == idle_thread)
     idle_ticks++;
-#ifdef USERPROG
-  else if (t->pagedir != NULL)
-    user_ticks++;
-#endif
+  else if (f != NULL && (f->cs & 3) == 3)
+    {
+      user_ticks++;
+      t->rusage.user_ticks++;
+    }
   else
-    kernel_ticks++;
+    {
+      kernel_ticks++;
+      t->rusage.kernel_ticks++;
+    }
+
+  /* Enforce the EDF budget: a thread that has used up its
+     runtime sits out the rest of its period. */
+  if (t->dl_runtime > 0 && --t->dl_budget <= 0 && !t->dl_sleeping)
+    {
+      t->dl_sleeping = true;
+      t->dl_overruns++;
+      intr_yield_on_return ();
+    }
 
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
-
-  check_block_list(current_ticks);
 }
 
 /* Prints thread statistics. */
@@ -257,6 +256,109 @@ thread_print_stats (void)
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  printf ("Thread cache: %lld hits, %lld misses, %zu pages cached\n",
+          thread_cache_hits, thread_cache_misses, thread_cache_cnt);
+  if (thread_stats)
+    {
+      enum intr_level old_level = intr_disable ();
+      struct list_elem *e;
+
+      for (e = list_begin (&all_list); e != list_end (&all_list);
+           e = list_next (e))
+        thread_print_usage (list_entry (e, struct thread, allelem));
+      intr_set_level (old_level);
+    }
+}
+
+/* Prints T's resource usage. */
+void
+thread_print_usage (struct thread *t) 
+{
+  const struct rusage *ru = &t->rusage;
+
+  printf ("Usage of %s (tid %d): %lld user ticks, %lld kernel ticks, "
+          "%u voluntary and %u involuntary switches, %u page faults, "
+          "%u sectors read, %u written\n",
+          t->name, t->tid, ru->user_ticks, ru->kernel_ticks,
+          ru->voluntary_switches, ru->involuntary_switches,
+          ru->page_faults, ru->blocks_read, ru->blocks_written);
+}
+
+/* Adds the resource usage in SRC to DST. */
+void
+rusage_add (struct rusage *dst, const struct rusage *src) 
+{
+  dst->user_ticks += src->user_ticks;
+  dst->kernel_ticks += src->kernel_ticks;
+  dst->voluntary_switches += src->voluntary_switches;
+  dst->involuntary_switches += src->involuntary_switches;
+  dst->page_faults += src->page_faults;
+  dst->blocks_read += src->blocks_read;
+  dst->blocks_written += src->blocks_written;
+}
+
+/* Returns a page from the cache of exited threads, or a null
+   pointer if the cache is empty. */
+static struct thread *
+thread_cache_get (void) 
+{
+  struct thread *t = NULL;
+  enum intr_level old_level = intr_disable ();
+
+  if (!list_empty (&thread_cache))
+    {
+      t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+      thread_cache_cnt--;
+      thread_cache_hits++;
+    }
+  else
+    thread_cache_misses++;
+  intr_set_level (old_level);
+
+  return t;
+}
+
+/* Puts the page of dead thread T into the cache, or frees it if
+   the cache is already full. */
+static void
+thread_cache_put (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_DYING);
+
+  if (thread_cache_cnt < thread_cache_max)
+    {
+      list_push_front (&thread_cache, &t->elem);
+      thread_cache_cnt++;
+    }
+  else
+    palloc_free_page (t);
+}
+
+/* Frees cached thread pages until at most KEEP remain.  Returns
+   the number of pages freed.  The page allocator calls this when
+   the kernel pool runs dry. */
+size_t
+thread_cache_trim (size_t keep) 
+{
+  size_t freed = 0;
+
+  for (;;)
+    {
+      struct thread *t = NULL;
+      enum intr_level old_level = intr_disable ();
+      if (thread_cache_cnt > keep)
+        {
+          t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+          thread_cache_cnt--;
+        }
+      intr_set_level (old_level);
+
+      if (t == NULL)
+        return freed;
+      palloc_free_page (t);
+      freed++;
+    }
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -291,7 +393,9 @@ thread_create (const char *name, int priority,
 
   // printf("create %d\n", priority);
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = thread_cache_get ();
+  if (t == NULL)
+    t = palloc_get_page (PAL_ZERO);
   if (t == NULL)
     return TID_ERROR;
 
@@ -327,14 +431,16 @@ thread_create (const char *name, int priority,
   // ---Solutie---
   // printf("check\n");
 
+#ifdef USERPROG
   t->parent = thread_current();
     // ---Solutie---
   // printf("%s has child %s \n", thread_current()->name, name);
   list_push_back(&thread_current()->children, &t->child_elem);
   thread_current()->child_load_status = tid;
+#endif
+
+  check_priority ();
 
-  // check_priority();
-  
   return tid;
 }
 
@@ -376,37 +482,22 @@ thread_unblock (struct thread *t)
   // printf("unblock %s status %d\n", t->name, t->status);
   ASSERT (t->status == THREAD_BLOCKED);
 
-  //list_push_back (&ready_list, &t->elem);
-  // ---Solutie---
-  list_insert_ordered(&ready_list, &t->elem, (list_less_func *)cmp_priority, NULL);
+  if (thread_mlfqs)
+    {
+      mlfqs_catch_up (t);
+      t->priority = mlfqs_priority (t);
+    }
 
+  // ---Solutie---
   t->status = THREAD_READY;
+  ready_queue_push (t);
+  TRACE (TRACE_WAKEUP, t->tid, thread_current ()->tid, t->priority);
 
   intr_set_level (old_level);
 }
 
 
 
-// ---Solutie---
-void
-thread_sleep_until (int64_t sleep_until) 
-{
-  // printf("[begin]thread_sleep_until\n");
-  enum intr_level old_level = intr_disable ();
-
-  struct thread *t = thread_current ();
-  t->sleep_until = sleep_until;
-  list_insert_ordered(&block_list, &t->elem, (list_less_func *)cmp_sleep_until, NULL);
-
-  // print_list(&block_list);
-  thread_block();
-
-  intr_set_level (old_level);
-
-  // printf("[end]thread_sleep_until\n");
-}
-
-
 /* Returns the name of the running thread. */
 const char *
 thread_name (void) 
@@ -451,10 +542,15 @@ thread_exit (void)
   process_exit ();
 #endif
 
+  if (thread_stats)
+    thread_print_usage (thread_current ());
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
   intr_disable ();
+  if (thread_current ()->dl_runtime > 0)
+    edf_leave (thread_current ());
   list_remove (&thread_current()->allelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
@@ -462,7 +558,9 @@ thread_exit (void)
 }
 
 /* Yields the CPU.  The current thread is not put to sleep and
-   may be scheduled again immediately at the scheduler's whim. */
+   may be scheduled again immediately at the scheduler's whim,
+   unless it is an EDF thread that has used up its budget, which
+   blocks until its next period. */
 void
 thread_yield (void) 
 {
@@ -472,10 +570,18 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  if (cur != idle_thread) 
-    list_insert_ordered(&ready_list, &cur->elem, (list_less_func *)cmp_priority, NULL);
-    // list_push_back (&ready_list, &cur->elem);
-  cur->status = THREAD_READY;
+  if (cur->dl_sleeping)
+    {
+      /* Out of EDF budget: sit out the rest of the period. */
+      TRACE (TRACE_BLOCK, cur->tid, 0, TRACE_REASON_OTHER);
+      cur->status = THREAD_BLOCKED;
+    }
+  else
+    {
+      cur->status = THREAD_READY;
+      if (cur != idle_thread) 
+        ready_queue_push (cur);
+    }
   schedule ();
   intr_set_level (old_level);
 }
@@ -483,17 +589,9 @@ thread_yield (void)
 void
 thread_yield__ (struct thread *cur) 
 {
-  enum intr_level old_level;
-  
-  ASSERT (!intr_context ());
+  ASSERT (cur == thread_current ());
 
-  old_level = intr_disable ();
-  if (cur != idle_thread) 
-    list_insert_ordered(&ready_list, &cur->elem, (list_less_func *)cmp_priority, NULL);
-    // list_push_back (&ready_list, &cur->elem);
-  cur->status = THREAD_READY;
-  schedule ();
-  intr_set_level (old_level);
+  thread_yield ();
 }
 
 /* Invoke function 'func' on all threads, passing along 'aux'.
@@ -517,15 +615,18 @@ thread_foreach (thread_action_func *func, void *aux)
 void
 thread_set_priority (int new_priority) 
 {
-  int old_priority = thread_current()->priority;
-  thread_current()->priority = new_priority;
-  thread_current()->original_priority = new_priority;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
-  if (old_priority > new_priority) 
-  {
-    donation_release();
-    // check_priority();
-  }
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  cur->base_priority = new_priority;
+  thread_update_priority (cur);
+  intr_set_level (old_level);
+
+  check_priority ();
 }
 
 /* Returns the current thread's priority. */
@@ -535,6 +636,308 @@ thread_get_priority (void)
   return thread_current ()->priority;
 }
 
+/* Moves the current thread into the EDF class: every PERIOD
+   ticks it is released with a budget of RUNTIME ticks that must
+   be consumed within DEADLINE ticks.  A RUNTIME of 0 moves it
+   back to the priority class.  Returns false, leaving the
+   thread unchanged, if the parameters are invalid or admitting
+   the thread would push the total EDF bandwidth past
+   EDF_BW_MAX. */
+bool
+thread_set_deadline (int64_t runtime, int64_t period, int64_t deadline)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int64_t bw = 0;
+
+  ASSERT (!intr_context ());
+
+  if (runtime != 0)
+    {
+      if (runtime < 0 || runtime > deadline || deadline > period)
+        return false;
+      bw = (runtime << EDF_BW_SHIFT) / deadline;
+    }
+
+  old_level = intr_disable ();
+  if (edf_bandwidth - edf_thread_bandwidth (cur) + bw > EDF_BW_MAX)
+    {
+      intr_set_level (old_level);
+      return false;
+    }
+  if (cur->dl_runtime > 0)
+    edf_leave (cur);
+  if (runtime != 0)
+    {
+      int64_t now = timer_ticks ();
+
+      edf_bandwidth += bw;
+      cur->dl_runtime = runtime;
+      cur->dl_period = period;
+      cur->dl_deadline = deadline;
+      cur->dl_abs_deadline = now + deadline;
+      cur->dl_budget = runtime;
+      cur->dl_done = false;
+      cur->dl_sleeping = false;
+      cur->dl_misses = cur->dl_overruns = 0;
+      timer_add (&cur->dl_timer, now + period, edf_release, cur);
+    }
+  intr_set_level (old_level);
+
+  check_priority ();
+  return true;
+}
+
+/* Ends the current EDF thread's job for this period.  The thread
+   sleeps until its next release. */
+void
+thread_deadline_yield (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (!intr_context ());
+
+  if (cur->dl_runtime == 0)
+    return;
+
+  old_level = intr_disable ();
+  cur->dl_done = true;
+  if (timer_ticks () > cur->dl_abs_deadline)
+    cur->dl_misses++;
+  cur->dl_sleeping = true;
+  TRACE (TRACE_BLOCK, cur->tid, 0, TRACE_REASON_OTHER);
+  thread_block ();
+  intr_set_level (old_level);
+}
+
+/* Returns the number of jobs of the current EDF thread that
+   missed their deadlines. */
+unsigned
+thread_get_deadline_misses (void)
+{
+  return thread_current ()->dl_misses;
+}
+
+/* Returns the number of periods in which the current EDF thread
+   used up its budget and was throttled. */
+unsigned
+thread_get_deadline_overruns (void)
+{
+  return thread_current ()->dl_overruns;
+}
+
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest
+   priority. */
+void
+thread_set_nice (int nice) 
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (nice < NICE_MIN)
+    nice = NICE_MIN;
+  else if (nice > NICE_MAX)
+    nice = NICE_MAX;
+
+  old_level = intr_disable ();
+  cur->nice = nice;
+  if (thread_mlfqs)
+    thread_mlfqs_update_priority (cur);
+  intr_set_level (old_level);
+
+  check_priority ();
+}
+
+/* Returns the current thread's nice value. */
+int
+thread_get_nice (void) 
+{
+  return thread_current ()->nice;
+}
+
+/* Returns 100 times the system load average. */
+int
+thread_get_load_avg (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  int value = FP_ROUND (FP_MULT_MIX (load_avg, 100));
+  intr_set_level (old_level);
+  return value;
+}
+
+/* Returns 100 times the current thread's recent_cpu value. */
+int
+thread_get_recent_cpu (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  int value = FP_ROUND (FP_MULT_MIX (thread_current ()->recent_cpu, 100));
+  intr_set_level (old_level);
+  return value;
+}
+
+/* Charges the running thread for the current timer tick.
+   Called from the timer interrupt. */
+void
+thread_mlfqs_increase_recent_cpu (void)
+{
+  struct thread *cur = thread_current ();
+
+  ASSERT (intr_context ());
+
+  if (cur != idle_thread)
+    cur->recent_cpu = FP_ADD_MIX (cur->recent_cpu, 1);
+}
+
+/* Recomputes T's priority from its recent_cpu and nice values.
+   When T is the running thread and some ready thread now has a
+   higher priority, yields on return from the timer interrupt. */
+void
+thread_mlfqs_update_priority (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t == idle_thread)
+    return;
+
+  thread_set_effective_priority (t, mlfqs_priority (t));
+  if (intr_context () && t == thread_current ()
+      && thread_preempts (ready_queue_front ()))
+    intr_yield_on_return ();
+}
+
+/* Once-per-second MLFQS update, called from the timer interrupt.
+   Updates the load average, then decays recent_cpu and recomputes
+   the priority of the running thread and every ready thread.
+   Blocked threads are skipped (see mlfqs_catch_up()), so the
+   cost is proportional to the number of runnable threads rather
+   than the number of threads in the system.  The ready queues
+   are drained into one batch and refilled afterward, keeping the
+   original relative order of the threads. */
+void
+thread_mlfqs_update_load_avg_and_recent_cpu (void)
+{
+  struct thread *cur = thread_current ();
+  struct list batch;
+  fixed_point twice_load, coef;
+  int ready_threads;
+  int pri;
+
+  ASSERT (intr_context ());
+
+  ready_threads = ready_cnt + (cur != idle_thread ? 1 : 0);
+  load_avg = FP_ADD (FP_DIV_MIX (FP_MULT_MIX (load_avg, 59), 60),
+                     FP_DIV_MIX (FP_CONVT (ready_threads), 60));
+  mlfqs_seconds++;
+  load_avg_history[mlfqs_seconds % LOAD_AVG_HISTORY] = load_avg;
+
+  twice_load = FP_MULT_MIX (load_avg, 2);
+  coef = FP_DIV (twice_load, FP_ADD_MIX (twice_load, 1));
+
+  if (cur != idle_thread)
+    {
+      cur->recent_cpu = FP_ADD_MIX (FP_MULT (coef, cur->recent_cpu),
+                                    cur->nice);
+      cur->recent_cpu_epoch = mlfqs_seconds;
+      thread_mlfqs_update_priority (cur);
+    }
+
+  list_init (&batch);
+  for (pri = PRI_MAX; pri >= PRI_MIN; pri--)
+    if (!list_empty (&ready_queues[pri]))
+      list_splice (list_end (&batch), list_begin (&ready_queues[pri]),
+                   list_end (&ready_queues[pri]));
+  ready_mask = 0;
+  ready_cnt = heap_size (&edf_ready);
+
+  while (!list_empty (&batch))
+    {
+      struct thread *t = list_entry (list_pop_front (&batch),
+                                     struct thread, elem);
+      t->recent_cpu = FP_ADD_MIX (FP_MULT (coef, t->recent_cpu), t->nice);
+      t->recent_cpu_epoch = mlfqs_seconds;
+      t->priority = mlfqs_priority (t);
+      ready_queue_push (t);
+    }
+
+  if (thread_preempts (ready_queue_front ()))
+    intr_yield_on_return ();
+}
+
+/* Returns the MLFQS priority for T:
+   PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to the valid
+   priority range. */
+static int
+mlfqs_priority (const struct thread *t)
+{
+  int priority = PRI_MAX - FP_ROUND (FP_DIV_MIX (t->recent_cpu, 4))
+                 - t->nice * 2;
+
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  return priority;
+}
+
+/* Returns fixed-point X raised to the nonnegative integer power
+   EXP, by repeated squaring. */
+static fixed_point
+fp_pow (fixed_point x, unsigned exp)
+{
+  fixed_point result = FP_CONVT (1);
+
+  while (exp > 0)
+    {
+      if (exp & 1)
+        result = FP_MULT (result, x);
+      x = FP_MULT (x, x);
+      exp >>= 1;
+    }
+  return result;
+}
+
+/* Brings the recent_cpu of thread T, which was blocked, up to
+   date by replaying the once-per-second decays it missed.  The
+   last LOAD_AVG_HISTORY seconds are replayed exactly.  Any older
+   seconds are folded into one closed-form step that assumes the
+   oldest recorded load average held throughout, so the cost is
+   bounded no matter how long T slept. */
+static void
+mlfqs_catch_up (struct thread *t)
+{
+  unsigned missed = mlfqs_seconds - t->recent_cpu_epoch;
+
+  if (missed > LOAD_AVG_HISTORY)
+    {
+      /* For constant coefficient C, M steps of R = C * R + NICE
+         give C^M * R + NICE * (1 - C^M) / (1 - C), where
+         1 / (1 - C) = 2 * load_avg + 1. */
+      unsigned oldest = mlfqs_seconds - LOAD_AVG_HISTORY + 1;
+      fixed_point twice_load
+        = FP_MULT_MIX (load_avg_history[oldest % LOAD_AVG_HISTORY], 2);
+      fixed_point scale = FP_ADD_MIX (twice_load, 1);
+      fixed_point cm = fp_pow (FP_DIV (twice_load, scale),
+                               missed - LOAD_AVG_HISTORY);
+      fixed_point tail = FP_MULT (FP_SUB (FP_CONVT (1), cm), scale);
+
+      t->recent_cpu = FP_ADD (FP_MULT (cm, t->recent_cpu),
+                              FP_MULT_MIX (tail, t->nice));
+      missed = LOAD_AVG_HISTORY;
+    }
+
+  for (; missed > 0; missed--)
+    {
+      unsigned s = mlfqs_seconds - missed + 1;
+      fixed_point twice_load
+        = FP_MULT_MIX (load_avg_history[s % LOAD_AVG_HISTORY], 2);
+      fixed_point coef = FP_DIV (twice_load, FP_ADD_MIX (twice_load, 1));
+      t->recent_cpu = FP_ADD_MIX (FP_MULT (coef, t->recent_cpu), t->nice);
+    }
+  t->recent_cpu_epoch = mlfqs_seconds;
+}
+
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
@@ -558,6 +961,19 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Zero free pages ahead of PAL_ZERO requests while nothing
+         else is ready to run. */
+      intr_enable ();
+      while (ready_cnt == 0 && palloc_zero_idle ())
+        continue;
+      intr_disable ();
+      if (ready_cnt > 0)
+        continue;
+
+      /* In tickless mode, stop the periodic timer tick until
+         the next timer is due. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -621,18 +1037,35 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+  if (thread_mlfqs)
+    {
+      /* New threads inherit nice and recent_cpu from their
+         parent.  The initial thread starts from zero. */
+      struct thread *parent = running_thread ();
+      if (parent != t && is_thread (parent))
+        {
+          t->nice = parent->nice;
+          t->recent_cpu = parent->recent_cpu;
+        }
+      t->recent_cpu_epoch = mlfqs_seconds;
+      t->priority = mlfqs_priority (t);
+    }
   t->magic = THREAD_MAGIC;
   list_push_back (&all_list, &t->allelem);
 
-  // ---Solutie---
-  // Init donation 
-  // t->is_donated = false;
-  t->original_priority = priority;
-  t->locked_by = NULL;
-  list_init(&t->threads_locked);
+  t->base_priority = t->priority;
+  t->waiting_lock = NULL;
+  list_init (&t->held_locks);
+  t->waiting_rwlock = NULL;
+  t->waitq = NULL;
+#ifdef USERPROG
   list_init(&t->open_fd);
   list_init(&t->children);
   sema_init(&t->process_wait, 0);
+#endif
+#ifdef VM
+  list_init (&t->mappings);
+#endif
 
   // error ! kenel panic
   // t->parent = thread_current();
@@ -640,7 +1073,6 @@ init_thread (struct thread *t, const char *name, int priority)
   // ---Solutie---
   // struct file *file = filesys_open (name);
   // file_deny_write(file);
-  // print_list(&t->threads_locked);
   // printf("init_thread end\n");
 }
 
@@ -665,10 +1097,207 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  if (ready_cnt == 0)
     return idle_thread;
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    return ready_queue_pop ();
+}
+
+/* Appends ready thread T to the queue for its priority, or adds
+   it to edf_ready if it is an EDF thread. */
+static void
+ready_queue_push (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  ready_cnt++;
+  if (t->dl_runtime > 0)
+    {
+      heap_insert (&edf_ready, &t->edf_elem);
+      return;
+    }
+  list_push_back (&ready_queues[t->priority], &t->elem);
+  ready_mask |= (uint64_t) 1 << t->priority;
+}
+
+/* Removes ready thread T from the queue it is in. */
+static void
+ready_queue_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+
+  ready_cnt--;
+  if (t->dl_runtime > 0)
+    {
+      heap_remove (&edf_ready, &t->edf_elem);
+      return;
+    }
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[t->priority]))
+    ready_mask &= ~((uint64_t) 1 << t->priority);
+}
+
+/* Removes and returns the ready thread that should run next.  At
+   least one thread must be ready. */
+static struct thread *
+ready_queue_pop (void)
+{
+  struct thread *t = ready_queue_front ();
+
+  ASSERT (t != NULL);
+
+  ready_queue_remove (t);
+  return t;
+}
+
+/* Returns the ready thread that should run next: the EDF thread
+   with the earliest deadline if there is one, otherwise the
+   thread at the front of the highest nonempty ready queue.
+   Returns a null pointer if no thread is ready. */
+static struct thread *
+ready_queue_front (void)
+{
+  int pri;
+
+  if (!heap_empty (&edf_ready))
+    return heap_entry (heap_max (&edf_ready), struct thread, edf_elem);
+
+  pri = ready_queue_max_priority ();
+  if (pri < PRI_MIN)
+    return NULL;
+  return list_entry (list_front (&ready_queues[pri]), struct thread, elem);
+}
+
+/* Returns true if T should run in preference to the running
+   thread, false if T is a null pointer. */
+bool
+thread_preempts (const struct thread *t)
+{
+  return t != NULL && outranks (t, thread_current ());
+}
+
+/* Returns true if A should run in preference to B.  EDF threads
+   outrank all others and are ordered by absolute deadline among
+   themselves; the rest are ordered by priority. */
+static bool
+outranks (const struct thread *a, const struct thread *b)
+{
+  if (a->dl_runtime > 0)
+    return b->dl_runtime == 0 || a->dl_abs_deadline < b->dl_abs_deadline;
+  else if (b->dl_runtime > 0)
+    return false;
+  else
+    return a->priority > b->priority;
+}
+
+/* Orders edf_ready so that the earliest deadline is the max. */
+static bool
+edf_less (const struct heap_elem *a_, const struct heap_elem *b_,
+          void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, edf_elem);
+  const struct thread *b = heap_entry (b_, struct thread, edf_elem);
+
+  return a->dl_abs_deadline > b->dl_abs_deadline;
+}
+
+/* Timer callback that releases EDF thread AUX's next job: the
+   budget is refilled and the deadline moves on one period.  A
+   job still unfinished at this point missed its deadline.
+   Runs in the timer interrupt. */
+static void
+edf_release (void *aux)
+{
+  struct thread *t = aux;
+  int64_t release = t->dl_timer.expires;
+
+  if (!t->dl_done)
+    t->dl_misses++;
+
+  if (t->status == THREAD_READY)
+    ready_queue_remove (t);
+  t->dl_abs_deadline = release + t->dl_deadline;
+  t->dl_budget = t->dl_runtime;
+  t->dl_done = false;
+  if (t->status == THREAD_READY)
+    ready_queue_push (t);
+  timer_add (&t->dl_timer, release + t->dl_period, edf_release, t);
+
+  if (t->dl_sleeping)
+    {
+      t->dl_sleeping = false;
+      if (t->status == THREAD_BLOCKED)
+        thread_unblock (t);
+    }
+  if (thread_preempts (ready_queue_front ()))
+    intr_yield_on_return ();
+}
+
+/* Returns the share of the CPU reserved by EDF thread T, in
+   units of 1 / (1 << EDF_BW_SHIFT), or 0 if T is not an EDF
+   thread. */
+static int64_t
+edf_thread_bandwidth (const struct thread *t)
+{
+  if (t->dl_runtime == 0)
+    return 0;
+  return (t->dl_runtime << EDF_BW_SHIFT) / t->dl_deadline;
+}
+
+/* Takes T out of the EDF class, returning its bandwidth.
+   Interrupts must be off. */
+static void
+edf_leave (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_RUNNING);
+
+  timer_cancel (&t->dl_timer);
+  edf_bandwidth -= edf_thread_bandwidth (t);
+  t->dl_runtime = 0;
+  t->dl_sleeping = false;
+}
+
+/* Returns the priority of the highest-priority ready thread, or
+   PRI_MIN - 1 if no thread is ready. */
+static int
+ready_queue_max_priority (void)
+{
+  if (ready_mask == 0)
+    return PRI_MIN - 1;
+  return 63 - __builtin_clzll (ready_mask);
+}
+
+/* Changes T's effective priority to PRIORITY, moving T to the
+   matching ready queue if it is currently waiting to run, or
+   repositioning it in the wait queue it is blocked on. */
+static void
+thread_set_effective_priority (struct thread *t, int priority)
+{
+  enum intr_level old_level;
+
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  old_level = intr_disable ();
+  if (t->priority != priority)
+    TRACE (TRACE_PRIORITY, t->tid, 0, priority);
+  if (t->status == THREAD_READY && t->priority != priority)
+    {
+      ready_queue_remove (t);
+      t->priority = priority;
+      ready_queue_push (t);
+    }
+  else if (t->waitq != NULL && t->priority != priority)
+    {
+      t->priority = priority;
+      waitq_reorder (t);
+    }
+  else
+    t->priority = priority;
+  intr_set_level (old_level);
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -713,7 +1342,7 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != cur);
-      palloc_free_page (prev);
+      thread_cache_put (prev);
     }
 }
 
@@ -736,7 +1365,14 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      if (cur->status == THREAD_READY)
+        cur->rusage.involuntary_switches++;
+      else if (cur->status == THREAD_BLOCKED)
+        cur->rusage.voluntary_switches++;
+      TRACE (TRACE_SWITCH, cur->tid, next->tid, cur->status);
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
@@ -758,56 +1394,77 @@ allocate_tid (void)
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof (struct thread, stack);
 
-// ---Solutie---
-void
-donation_acquire(void) 
+/* Returns the greater of PRIORITY and that of the first thread
+   in WQ. */
+static int
+donated_priority (const struct waitq *wq, int priority)
 {
-  // printf("donation_acquire\n");
-  int depth = DEPTH;
-  struct thread* cur = thread_current();
-
-  // printf("donation %d\n", thread_current()->name);
-  // if (cur->locked_by == NULL) {
-  //   printf("donation depth %d\n", depth);
-  // }
-
-  while (cur->locked_by != NULL && depth > 0) 
-  {
-    depth -= 1;
-    struct thread* pre = cur->locked_by->holder;
-    // printf("donation_acquire : %s %d\n", 
-    //     pre->name, pre->priority);
-
-    if (pre != NULL && pre->priority < cur->priority) {
-      pre->priority = cur->priority;
-
-      cur = pre;
-    } 
-    else 
-      return;
-  }
+  struct thread *donor = waitq_front (wq);
+  return donor != NULL && donor->priority > priority ? donor->priority
+                                                     : priority;
 }
 
-// ---Solutie---
-void 
-donation_release(void)
-{ 
-  // printf("release\n");
-  struct thread *cur = thread_current();
-  cur->priority = cur->original_priority;
-
-  if (!list_empty(&cur->threads_locked)) 
-  {
+/* Recomputes T's effective priority from its base priority and
+   the threads waiting on the locks and rwlocks that it holds.
+   If T is itself waiting on a lock, the change is passed along
+   to that lock's holder, and so on down the chain, stopping as
+   soon as a thread's priority comes out unchanged.  A thread
+   waiting on an rwlock passes the change to every holder.
 
-    // print_list(&cur->threads_locked);
-    struct thread *next = list_entry(list_begin(&cur->threads_locked),
-      struct thread, donate_elem);
-    // struct thread *next = list_entry(list_begin(&cur->threads_locked),
-    //   struct thread, elem);
+   Each step costs O(log n) in the number of waiters on the lock
+   being waited for, plus the number of locks the thread holds.
+   Does nothing under the MLFQS, which does not donate. */
+void
+thread_update_priority (struct thread *t)
+{
+  enum intr_level old_level;
 
-    if (next->priority > cur->priority) {
-      cur->priority = next->priority;
-    }
+  if (thread_mlfqs)
+    return;
 
-  }
+  old_level = intr_disable ();
+  while (t != NULL)
+    {
+      int priority = t->base_priority;
+      struct list_elem *e;
+      struct lock *lock;
+      struct rwlock *rw;
+      int i;
+
+      for (e = list_begin (&t->held_locks); e != list_end (&t->held_locks);
+           e = list_next (e))
+        {
+          struct lock *held = list_entry (e, struct lock, elem);
+          priority = donated_priority (&held->waiters, priority);
+        }
+      for (i = 0; i < RW_HOLD_CNT; i++)
+        {
+          struct rwlock *held = t->rw_holds[i].rwlock;
+          if (held != NULL)
+            {
+              priority = donated_priority (&held->readers, priority);
+              priority = donated_priority (&held->writers, priority);
+            }
+        }
+      if (priority == t->priority)
+        break;
+
+      thread_set_effective_priority (t, priority);
+      lock = t->waiting_lock;
+      rw = t->waiting_rwlock;
+      if (lock != NULL && t->waitq == &lock->waiters)
+        t = lock->holder;
+      else if (rw != NULL
+               && (t->waitq == &rw->readers || t->waitq == &rw->writers))
+        {
+          for (e = list_begin (&rw->holders); e != list_end (&rw->holders);
+               e = list_next (e))
+            thread_update_priority (list_entry (e, struct rw_hold,
+                                                elem)->thread);
+          break;
+        }
+      else
+        break;
+    }
+  intr_set_level (old_level);
 }
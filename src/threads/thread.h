@@ -4,9 +4,14 @@
 // add
 #include "threads/fixed-point.h"
 #include "threads/synch.h"
+#include "devices/timer.h"
 
 #include <debug.h>
+#include <hash.h>
+#include <heap.h>
 #include <list.h>
+#include <rusage.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -28,6 +33,11 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
+
+/* Thread nice values. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default nice value. */
+#define NICE_MAX 20                     /* Least nice. */
 // #define PRI_MAX 630
 /* A kernel thread or user process.
    Each thread structure is stored in its own 4 kB page.  The
@@ -96,19 +106,42 @@ struct thread
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
-
-    // ---Solutie---
-    int64_t sleep_until;                /* End timestamp of sleep*/
-    int original_priority;   
-    struct lock *locked_by;
-    struct list threads_locked;
-    struct list_elem donate_elem;
-
-    // // add
-    // /* Variables needed for calculating priority of threads. */ 
-    // int nice;                            Nice value. 
-    // fixed_point recent_cpu;             /* Recent CPU value. */
-    // fixed_point load_avg;               /* Load_average value. */
+    struct waitq *waitq;                /* Wait queue, if waiting. */
+    struct heap_elem wait_elem;         /* Element in waitq. */
+    unsigned wait_seq;                  /* Arrival stamp in waitq. */
+
+    /* Priority donation.  PRIORITY above is the effective
+       priority: the greater of BASE_PRIORITY and the priorities
+       of the threads waiting on the locks and rwlocks held. */
+    int base_priority;                  /* Priority set by the thread. */
+    struct lock *waiting_lock;          /* Lock being acquired, if any. */
+    struct list held_locks;             /* Locks held by this thread. */
+    struct rwlock *waiting_rwlock;      /* Rwlock being acquired, if any. */
+    struct rw_hold rw_holds[RW_HOLD_CNT]; /* Rwlocks held. */
+
+    /* Earliest-deadline-first scheduling class, all times in
+       timer ticks.  DL_RUNTIME is 0 for threads scheduled by
+       priority.  A job is released at the start of each period
+       and ends when the thread calls thread_deadline_yield(). */
+    int64_t dl_runtime;                 /* CPU budget per period. */
+    int64_t dl_period;                  /* Period. */
+    int64_t dl_deadline;                /* Deadline, relative to release. */
+    int64_t dl_abs_deadline;            /* Current job's deadline. */
+    int64_t dl_budget;                  /* Budget left this period. */
+    bool dl_done;                       /* Current job finished? */
+    bool dl_sleeping;                   /* Off CPU until next release? */
+    unsigned dl_misses;                 /* Jobs that missed deadline. */
+    unsigned dl_overruns;               /* Periods budget ran out. */
+    struct timer dl_timer;              /* Fires at each release. */
+    struct heap_elem edf_elem;          /* Element in EDF ready heap. */
+
+    /* Resource usage, reported by getrusage(). */
+    struct rusage rusage;               /* This thread's own usage. */
+
+    /* Used by the multi-level feedback queue scheduler. */
+    int nice;                           /* Nice value. */
+    fixed_point recent_cpu;             /* Recent CPU value. */
+    unsigned recent_cpu_epoch;          /* Second recent_cpu is current to. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -121,6 +154,8 @@ struct thread
     struct list_elem child_elem;        /* List element for list children. */
     int child_load_status;              /* Load status of its child*/
     int child_exit_status;              /* Exit status of its child*/ 
+    struct rusage child_rusage;         /* Usage of its reaped children. */
+    struct rusage child_exit_rusage;    /* Usage of the child last exited. */
     
     struct list open_fd;                /* Fds the thread opens*/
     struct file *file;                  /* Executable file of this thread. */
@@ -128,6 +163,15 @@ struct thread
     struct semaphore process_wait;      /* Determine whether thread should wait. */
     // ---Solutie---
 
+#endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    void *user_esp;                     /* User stack pointer in syscalls. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
 #endif
 
     /* Owned by thread.c. */
@@ -139,16 +183,27 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* Maximum number of exited thread pages kept for reuse.
+   Controlled by kernel command-line option "-tcache=COUNT". */
+extern size_t thread_cache_max;
+size_t thread_cache_trim (size_t keep);
+
+/* If true, print each thread's resource usage when it exits and
+   that of every live thread at shutdown.  Controlled by kernel
+   command-line option "-stats". */
+extern bool thread_stats;
+
 // ---Solutie---
-bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
-bool cmp_donate (const struct list_elem *a, const struct list_elem *b, void *aux);
 void check_priority(void);
 
 void thread_init (void);
 void thread_start (void);
 
-void thread_tick (int64_t current_ticks);
+struct intr_frame;
+void thread_tick (struct intr_frame *);
 void thread_print_stats (void);
+void thread_print_usage (struct thread *);
+void rusage_add (struct rusage *, const struct rusage *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -156,9 +211,6 @@ tid_t thread_create (const char *name, int priority, thread_func *, void *);
 void thread_block (void);
 void thread_unblock (struct thread *);
 
-// ---Solutie---
-void thread_sleep_until (int64_t sleep_until);
-
 struct thread *thread_current (void);
 tid_t thread_tid (void);
 const char *thread_name (void);
@@ -174,14 +226,22 @@ void thread_foreach (thread_action_func *, void *);
 int thread_get_priority (void);
 void thread_set_priority (int);
 
-// int thread_get_nice (void);
-// void thread_set_nice (int);
-// int thread_get_recent_cpu (void);
-// int thread_get_load_avg (void);
+int thread_get_nice (void);
+void thread_set_nice (int);
+int thread_get_recent_cpu (void);
+int thread_get_load_avg (void);
 
-// ---Solutie---
-void donation_acquire(void);
-void donation_release(void);
+void thread_mlfqs_increase_recent_cpu (void);
+void thread_mlfqs_update_load_avg_and_recent_cpu (void);
+void thread_mlfqs_update_priority (struct thread *);
+
+void thread_update_priority (struct thread *);
+bool thread_preempts (const struct thread *);
+
+bool thread_set_deadline (int64_t runtime, int64_t period, int64_t deadline);
+void thread_deadline_yield (void);
+unsigned thread_get_deadline_misses (void);
+unsigned thread_get_deadline_overruns (void);
 
 
 #endif /* threads/thread.h */
@@ -0,0 +1,169 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#endif
+
+/* Number of records in the ring buffer.  Must be a power of 2,
+   so that trace_event() can wrap HEAD with a mask instead of a
+   64-bit modulo, which would be a libgcc call on the i386. */
+#define TRACE_CAPACITY 4096
+#define TRACE_MASK (TRACE_CAPACITY - 1)
+
+/* Number of pages in the ring buffer. */
+#define TRACE_PAGES \
+        DIV_ROUND_UP (TRACE_CAPACITY * sizeof (struct trace_record), PGSIZE)
+
+/* Identifies a trace dump on the scratch disk. */
+#define TRACE_MAGIC 0x32525450          /* "PTR2" */
+
+/* Header sector written at the start of a trace dump. */
+struct trace_header
+  {
+    uint32_t magic;             /* TRACE_MAGIC. */
+    uint32_t record_size;       /* sizeof (struct trace_record). */
+    uint32_t record_cnt;        /* Number of records that follow. */
+    uint32_t dropped;           /* Records overwritten before dump. */
+    int64_t start_ns;           /* timer_now_ns() at trace_init(). */
+    int64_t end_ns;             /* timer_now_ns() at trace_dump(). */
+  };
+
+/* True if events are being recorded. */
+bool trace_enabled;
+
+/* True to write the trace to the scratch disk at shutdown. */
+bool trace_dump_at_shutdown;
+
+/* Ring buffer.  Records are written at index HEAD & TRACE_MASK;
+   HEAD counts every record ever written. */
+static struct trace_record *records;
+static uint64_t head;
+
+static int64_t start_ns;
+
+/* Allocates the trace buffer and starts recording events. */
+void
+trace_init (void)
+{
+  records = palloc_get_multiple (PAL_ASSERT, TRACE_PAGES);
+  head = 0;
+  start_ns = timer_now_ns ();
+  trace_enabled = true;
+}
+
+/* Records an event of the given TYPE performed by thread A,
+   involving thread B, with argument ARG.  Use the TRACE macro
+   instead of calling this directly. */
+void
+trace_event (enum trace_type type, int a, int b, int arg)
+{
+  enum intr_level old_level = intr_disable ();
+  struct trace_record *r = &records[head++ & TRACE_MASK];
+  r->ns = timer_now_ns ();
+  r->type = type;
+  r->a = a;
+  r->b = b;
+  r->arg = arg;
+  intr_set_level (old_level);
+}
+
+/* Stops tracing and, if requested with -trace-dump, writes the
+   recorded events to the start of the scratch disk, oldest
+   first, preceded by a header sector. */
+void
+trace_dump (void)
+{
+#ifdef FILESYS
+  struct block *scratch;
+  struct trace_header *h;
+  uint64_t first, cnt;
+  uint8_t *sector;
+  block_sector_t sector_idx;
+  size_t ofs;
+#endif
+
+  if (records == NULL || !trace_dump_at_shutdown)
+    return;
+  trace_enabled = false;
+
+#ifdef FILESYS
+  scratch = block_get_role (BLOCK_SCRATCH);
+  if (scratch == NULL)
+    {
+      printf ("trace: no scratch device, trace not saved\n");
+      return;
+    }
+  if (intr_get_level () == INTR_OFF)
+    {
+      /* Disk I/O needs interrupts, which are off after a panic. */
+      printf ("trace: interrupts off, trace not saved\n");
+      return;
+    }
+
+  sector = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  cnt = head < TRACE_CAPACITY ? head : TRACE_CAPACITY;
+  first = head - cnt;
+
+  /* Shrink the dump to fit the scratch device if necessary. */
+  while (cnt > 0
+         && 1 + DIV_ROUND_UP (cnt * sizeof *records, BLOCK_SECTOR_SIZE)
+            > block_size (scratch))
+    {
+      first++;
+      cnt--;
+    }
+
+  h = (struct trace_header *) sector;
+  h->magic = TRACE_MAGIC;
+  h->record_size = sizeof *records;
+  h->record_cnt = cnt;
+  h->dropped = head - cnt;
+  h->start_ns = start_ns;
+  h->end_ns = timer_now_ns ();
+  block_write (scratch, 0, sector);
+
+  /* Records straddle sector boundaries, so pack them into the
+     bounce buffer one at a time. */
+  sector_idx = 1;
+  ofs = 0;
+  memset (sector, 0, BLOCK_SECTOR_SIZE);
+  for (; cnt > 0; first++, cnt--)
+    {
+      const uint8_t *src = (const uint8_t *) &records[first & TRACE_MASK];
+      size_t left = sizeof *records;
+      while (left > 0)
+        {
+          size_t chunk = BLOCK_SECTOR_SIZE - ofs;
+          if (chunk > left)
+            chunk = left;
+          memcpy (sector + ofs, src, chunk);
+          src += chunk;
+          left -= chunk;
+          ofs += chunk;
+          if (ofs == BLOCK_SECTOR_SIZE)
+            {
+              block_write (scratch, sector_idx++, sector);
+              memset (sector, 0, BLOCK_SECTOR_SIZE);
+              ofs = 0;
+            }
+        }
+    }
+  if (ofs > 0)
+    block_write (scratch, sector_idx++, sector);
+
+  printf ("trace: saved %"PRIu32" events (%"PRIu32" dropped) "
+          "in %"PRDSNu" sectors of scratch device\n",
+          h->record_cnt, h->dropped, sector_idx);
+  palloc_free_page (sector);
+#else
+  printf ("trace: no file system, trace not saved\n");
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Scheduler event tracing.
+
+   When enabled with the "-trace" kernel option, scheduler events
+   are recorded into a fixed-size ring buffer, overwriting the
+   oldest records once it fills.  With "-trace-dump", the buffer
+   is written to the scratch disk at shutdown, where
+   utils/pintos-trace2json can turn it into a Chrome/Perfetto
+   trace-event timeline.  While tracing is off, each trace point
+   costs a single test of trace_enabled. */
+
+/* Types of trace events.  Keep utils/pintos-trace2json in sync. */
+enum trace_type
+  {
+    TRACE_SWITCH,               /* A switched to B; ARG is A's new status. */
+    TRACE_WAKEUP,               /* A made ready by B; ARG is A's priority. */
+    TRACE_BLOCK,                /* A blocks; ARG is an enum trace_reason. */
+    TRACE_DONATE,               /* A donates priority ARG to B. */
+    TRACE_PRIORITY,             /* A's priority changes to ARG. */
+    TRACE_SEMA_UP,              /* A ups a semaphore, waking B (or 0). */
+    TRACE_TYPE_CNT
+  };
+
+/* Why a thread blocked, for TRACE_BLOCK. */
+enum trace_reason
+  {
+    TRACE_REASON_OTHER,         /* EDF throttling, intq, other. */
+    TRACE_REASON_SEMA,          /* Semaphore down. */
+    TRACE_REASON_LOCK,          /* Lock acquire; B is the holder. */
+    TRACE_REASON_SLEEP,         /* timer_sleep(). */
+    TRACE_REASON_COND,          /* Condition variable wait. */
+    TRACE_REASON_RWLOCK         /* Readers-writer lock acquire. */
+  };
+
+/* One trace record, as stored in memory and on disk. */
+struct trace_record
+  {
+    int64_t ns;                 /* timer_now_ns() at the event. */
+    uint32_t type;              /* An enum trace_type. */
+    int32_t a;                  /* Thread performing the event. */
+    int32_t b;                  /* Other thread involved, or 0. */
+    int32_t arg;                /* Event-specific argument. */
+  };
+
+extern bool trace_enabled;
+extern bool trace_dump_at_shutdown;
+
+void trace_init (void);
+void trace_event (enum trace_type, int a, int b, int arg);
+void trace_dump (void);
+
+/* Records an event if tracing is enabled. */
+#define TRACE(TYPE, A, B, ARG)                          \
+        do                                              \
+          {                                             \
+            if (trace_enabled)                          \
+              trace_event (TYPE, A, B, ARG);            \
+          }                                             \
+        while (0)
+
+#endif /* threads/trace.h */
@@ -0,0 +1,167 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Number of workers in system_wq. */
+#define SYSTEM_WQ_WORKERS 4
+
+struct workqueue system_wq;
+
+static thread_func worker;
+static bool is_finished (const struct work *);
+
+/* Initializes WQ as a queue called NAME whose work runs in at
+   most MAX_WORKERS threads of the given PRIORITY. */
+void
+workqueue_init (struct workqueue *wq, const char *name, int priority,
+                int max_workers) 
+{
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+  ASSERT (max_workers > 0);
+
+  strlcpy (wq->name, name, sizeof wq->name);
+  wq->priority = priority;
+  wq->max_workers = max_workers;
+  wq->worker_cnt = 0;
+  wq->idle_cnt = 0;
+  list_init (&wq->pending);
+  lock_init (&wq->lock);
+  cond_init (&wq->work_available);
+  cond_init (&wq->work_finished);
+}
+
+/* Initializes system_wq. */
+void
+workqueue_init_system (void) 
+{
+  workqueue_init (&system_wq, "kworker", PRI_DEFAULT, SYSTEM_WQ_WORKERS);
+}
+
+/* Submits W to system_wq to call FUNC with AUX. */
+void
+work_submit (struct work *w, work_func *func, void *aux) 
+{
+  work_submit_on (&system_wq, w, func, aux);
+}
+
+/* Submits W to WQ to call FUNC with AUX in a worker thread.  W
+   must not be queued already, but it may be running, so that
+   a work function can resubmit itself.  If no worker is parked
+   and the pool is not full, starts a new worker. */
+void
+work_submit_on (struct workqueue *wq, struct work *w, work_func *func,
+                void *aux) 
+{
+  ASSERT (wq != NULL);
+  ASSERT (w != NULL);
+  ASSERT (func != NULL);
+
+  lock_acquire (&wq->lock);
+  ASSERT (w->state != WORK_QUEUED);
+  w->func = func;
+  w->aux = aux;
+  w->state = WORK_QUEUED;
+  w->wq = wq;
+  list_push_back (&wq->pending, &w->elem);
+
+  if (wq->idle_cnt > 0)
+    cond_signal (&wq->work_available, &wq->lock);
+  else if (wq->worker_cnt < wq->max_workers)
+    {
+      char name[sizeof wq->name + 12];
+
+      snprintf (name, sizeof name, "%s/%d", wq->name, wq->worker_cnt);
+      if (thread_create (name, wq->priority, worker, wq) != TID_ERROR)
+        wq->worker_cnt++;
+    }
+  lock_release (&wq->lock);
+}
+
+/* Waits until W has been run or cancelled.  Returns at once if
+   it never was submitted. */
+void
+work_wait (struct work *w) 
+{
+  struct workqueue *wq = w->wq;
+
+  ASSERT (!intr_context ());
+
+  if (w->state == WORK_IDLE)
+    return;
+
+  lock_acquire (&wq->lock);
+  while (!is_finished (w))
+    cond_wait (&wq->work_finished, &wq->lock);
+  lock_release (&wq->lock);
+}
+
+/* Cancels W if it is still queued.  Returns true if it was,
+   false if it is already running or finished, in which case
+   work_wait() may be used to wait for it. */
+bool
+work_cancel (struct work *w) 
+{
+  struct workqueue *wq = w->wq;
+  bool cancelled = false;
+
+  if (w->state == WORK_IDLE)
+    return false;
+
+  lock_acquire (&wq->lock);
+  if (w->state == WORK_QUEUED)
+    {
+      list_remove (&w->elem);
+      w->state = WORK_CANCELLED;
+      cond_broadcast (&wq->work_finished, &wq->lock);
+      cancelled = true;
+    }
+  lock_release (&wq->lock);
+
+  return cancelled;
+}
+
+/* Worker thread for WQ_: runs queued work items, parking on the
+   queue while there are none. */
+static void
+worker (void *wq_) 
+{
+  struct workqueue *wq = wq_;
+
+  lock_acquire (&wq->lock);
+  for (;;) 
+    {
+      struct work *w;
+
+      while (list_empty (&wq->pending))
+        {
+          wq->idle_cnt++;
+          cond_wait (&wq->work_available, &wq->lock);
+          wq->idle_cnt--;
+        }
+
+      w = list_entry (list_pop_front (&wq->pending), struct work, elem);
+      w->state = WORK_RUNNING;
+      lock_release (&wq->lock);
+
+      w->func (w->aux);
+
+      lock_acquire (&wq->lock);
+      if (w->state == WORK_RUNNING)
+        {
+          w->state = WORK_DONE;
+          cond_broadcast (&wq->work_finished, &wq->lock);
+        }
+    }
+}
+
+/* Returns true if W has been run or cancelled. */
+static bool
+is_finished (const struct work *w) 
+{
+  return w->state == WORK_DONE || w->state == WORK_CANCELLED;
+}
@@ -0,0 +1,65 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* Function run by a worker thread for a work item. */
+typedef void work_func (void *aux);
+
+/* States of a work item. */
+enum work_state
+  {
+    WORK_IDLE,                  /* Never submitted. */
+    WORK_QUEUED,                /* Submitted, waiting for a worker. */
+    WORK_RUNNING,               /* Being run by a worker. */
+    WORK_DONE,                  /* Run to completion. */
+    WORK_CANCELLED              /* Cancelled before it ran. */
+  };
+
+/* A work item, and the handle for waiting on or cancelling it.
+   Owned by the submitter, which must keep it alive until it is
+   done or cancelled.  A new work item should have its `state'
+   member set to WORK_IDLE (zeroing it will do). */
+struct work
+  {
+    work_func *func;            /* Function to run. */
+    void *aux;                  /* Argument for FUNC. */
+    enum work_state state;      /* Current state. */
+    struct workqueue *wq;       /* Queue it was submitted to. */
+    struct list_elem elem;      /* Element in the queue's pending list. */
+  };
+
+/* A named pool of up to MAX_WORKERS kernel threads that run
+   submitted work items in the order submitted.  Workers are
+   created on demand and then stay parked on the queue while
+   there is no work. */
+struct workqueue
+  {
+    char name[16];              /* Name, also used for workers. */
+    int priority;               /* Priority of worker threads. */
+    int max_workers;            /* Maximum number of workers. */
+    int worker_cnt;             /* Number of workers created. */
+    int idle_cnt;               /* Number of workers parked. */
+    struct list pending;        /* Queued work items. */
+    struct lock lock;           /* Protects all of the above. */
+    struct condition work_available;    /* Signalled on submit. */
+    struct condition work_finished;     /* Broadcast on completion. */
+  };
+
+/* Shared queue for work with no particular needs. */
+extern struct workqueue system_wq;
+
+void workqueue_init (struct workqueue *, const char *name, int priority,
+                     int max_workers);
+void workqueue_init_system (void);
+
+void work_submit (struct work *, work_func *, void *aux);
+void work_submit_on (struct workqueue *, struct work *, work_func *,
+                     void *aux);
+void work_wait (struct work *);
+bool work_cancel (struct work *);
+
+#endif /* threads/workqueue.h */
@@ -4,7 +4,12 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
 #include "userprog/syscall.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Numar de defectiuni pe pagina procesate. */
 static long long page_fault_cnt;
@@ -119,6 +124,31 @@ page_fault (struct intr_frame *f)
 
   /* Numaram defectiunile paginii. */
   page_fault_cnt++;
+  thread_current ()->rusage.page_faults++;
+
+  /* Determinam cauza. */
+  not_present = (f->error_code & PF_P) == 0;
+  write = (f->error_code & PF_W) != 0;
+  user = (f->error_code & PF_U) != 0;
+
+#ifdef VM
+  /* Load the page on first touch, whether by the process itself
+     or by the kernel on its behalf during a system call, growing
+     the stack if that is what is being touched.  A fault in the
+     kernel does not save the user's stack pointer in F, so use
+     the one saved on entry to the system call.  Outside a system
+     call there is none, and the stack is not grown.  A thread
+     without a supplemental page table has nothing to load, so
+     its fault is reported below. */
+  if (not_present && fault_addr != NULL && is_user_vaddr (fault_addr)
+      && page_table_active (&thread_current ()->pages))
+    {
+      void *esp = user ? f->esp : thread_current ()->user_esp;
+      if (page_load (fault_addr)
+          || (esp != NULL && page_grow_stack (fault_addr, esp)))
+        return;
+    }
+#endif
 
   //------- Solutie------
   if (!not_present)
@@ -129,12 +159,6 @@ page_fault (struct intr_frame *f)
     exit(-1);
   //------- Solutie------
 
-
-  /* Determinam cauza. */
-  not_present = (f->error_code & PF_P) == 0;
-  write = (f->error_code & PF_W) != 0;
-  user = (f->error_code & PF_U) != 0;
-
   /* Pentru a implementa memoria virtuala, stergem restul functiei body-ului si o 
      inlocuim cu codul care ne aduce pagina care se refera la fault_addr. */
   printf ("Page fault at %p: %s error %s page in %s context.\n",
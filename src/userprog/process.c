@@ -15,8 +15,13 @@
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
@@ -95,9 +100,6 @@ start_process (void *args_)
      iar firul de executie fiu intra in asteptare pentru parintele lui. */
   sema_up(&thread_current()->parent->process_wait);
   sema_down(&thread_current()->process_wait);
-  /* Ne asiguram ca executabilul procesului care ruleaza nu poate fi modificat. */
-  thread_current()->file = filesys_open (thread_name());
-  file_deny_write(thread_current()->file);
   // ---Solutie---
 
   /* Pornim user process prin simularea unei returnari
@@ -146,6 +148,10 @@ process_wait (tid_t child_tid)
     sema_up(&child->process_wait);
     sema_down(&cur->process_wait);   
     status = cur->child_exit_status;
+
+    /* The child, now reaped, left its usage for us. */
+    rusage_add(&cur->child_rusage, &cur->child_exit_rusage);
+    memset(&cur->child_exit_rusage, 0, sizeof cur->child_exit_rusage);
   }
   
   return status;
@@ -158,6 +164,38 @@ process_exit (void)
 {
 
   struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+#ifdef VM
+  mmap_unmap_all ();
+  page_table_destroy (&cur->pages);
+#endif
+
+  /* Destroy the current process's page directory and switch back
+     to the kernel-only page directory. */
+  uint32_t *pd = cur->pagedir;
+  if (pd != NULL) 
+    {
+      /* Correct ordering here is crucial.  We must set
+         cur->pagedir to NULL before switching page directories,
+         so that a timer interrupt can't switch back to the
+         process page directory.  We must activate the base page
+         directory before destroying the process's page
+         directory, or our active page directory will be one
+         that's been freed (and cleared). */
+      cur->pagedir = NULL;
+      pagedir_activate (NULL);
+      pagedir_destroy (pd);
+    }
+
+  /* Let the executable be written again. */
+  file_close (cur->file);
+  cur->file = NULL;
+
+  /* Parent and children are only unlinked with interrupts off,
+     so that neither side can see the other's `struct thread'
+     after it is gone. */
+  old_level = intr_disable ();
 
   // ---Solutie---
   /* Deal with its parent --
@@ -166,6 +204,11 @@ process_exit (void)
      iar asteptarea parintelui se opreste. */
   if (cur->parent != NULL)
   {
+    /* Leave our usage, including the I/O and faults of the
+       teardown above and that of our own reaped children, for
+       the parent to fold in if it reaps us in process_wait(). */
+    cur->parent->child_exit_rusage = cur->rusage;
+    rusage_add(&cur->parent->child_exit_rusage, &cur->child_rusage);
     list_remove(&cur->child_elem);
     sema_up(&cur->parent->process_wait);
 
@@ -178,26 +221,12 @@ process_exit (void)
      e = list_next (e))
   {
     struct thread *tmp = list_entry (e, struct thread, child_elem);
+    tmp->parent = NULL;
     sema_up(&tmp->process_wait);
   }
   // ---Solutie---
 
-  /* Destroy the current process's page directory and switch back
-     to the kernel-only page directory. */
-  uint32_t *pd = cur->pagedir;
-  if (pd != NULL) 
-    {
-      /* Correct ordering here is crucial.  We must set
-         cur->pagedir to NULL before switching page directories,
-         so that a timer interrupt can't switch back to the
-         process page directory.  We must activate the base page
-         directory before destroying the process's page
-         directory, or our active page directory will be one
-         that's been freed (and cleared). */
-      cur->pagedir = NULL;
-      pagedir_activate (NULL);
-      pagedir_destroy (pd);
-    }
+  intr_set_level (old_level);
 }
 
 /* Sets up the CPU for running user code in the current
@@ -279,6 +308,9 @@ struct Elf32_Phdr
 #define PF_W 2          /* Writable. */
 #define PF_R 4          /* Readable. */
 
+/* Number of stack pages that may hold the command line. */
+#define STACK_ARG_PAGES 4
+
 static bool setup_stack (void **esp, const char *args);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
@@ -300,6 +332,12 @@ load (const char *args, void (**eip) (void), void **esp)
   bool success = false;
   int i;
 
+#ifdef VM
+  /* Allocate supplemental page table. */
+  if (!page_table_init (&t->pages))
+    goto done;
+#endif
+
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
@@ -397,14 +435,24 @@ load (const char *args, void (**eip) (void), void **esp)
   success = true;
 
  done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
+  /* We arrive here whether the load is successful or not.  On
+     success, keep the executable open, both to read its pages
+     from and to deny writes to it while it runs. */
+  if (success)
+    {
+      t->file = file;
+      file_deny_write (file);
+    }
+  else
+    file_close (file);
   return success;
 }
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -463,6 +511,9 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With VM, the pages are only recorded in the supplemental page
+   table, to be read from FILE when they are first touched.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool
@@ -482,6 +533,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      /* Record where to find this page. */
+      if (page_read_bytes > 0
+          ? !page_add_file (upage, file, ofs, page_read_bytes, writable)
+          : !page_add_zero (upage, writable))
+        return false;
+      ofs += page_read_bytes;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -501,6 +560,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false; 
         }
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
@@ -518,6 +578,18 @@ struct argument_addr
   uint32_t addr;
 };
 
+/* Cache of struct argument_addr. */
+static struct kmem_cache *argument_addr_cache;
+
+/* Initializes the process module. */
+void
+process_init (void)
+{
+  argument_addr_cache = kmem_cache_create ("argument_addr",
+                                           sizeof (struct argument_addr),
+                                           NULL);
+}
+
 // ---Solutie---
 /* Impinge un argument in stiva si apoi impinge addresa acestuia in lista */
 void push_argument_(void **esp, const char *arg, struct list *list) 
@@ -525,7 +597,7 @@ void push_argument_(void **esp, const char *arg, struct list *list)
   int len = strlen(arg) + 1;
   *esp -= len;
 
-  struct argument_addr *addr = malloc(sizeof(struct argument_addr));
+  struct argument_addr *addr = kmem_cache_alloc(argument_addr_cache);
   memcpy(*esp, arg, len);
 
   addr->addr = *esp;
@@ -585,6 +657,7 @@ void push_arguments(void **esp, const char *args)
       list_entry(list_pop_back(&list), struct argument_addr, list_elem);
     *esp -= 4;
     * (uint32_t *) *esp = addr->addr;
+    kmem_cache_free(argument_addr_cache, addr);
     // hex_dump(*esp, *esp, 64, true);
     // printf("%x\n", addr->addr);
   }
@@ -610,6 +683,19 @@ void push_arguments(void **esp, const char *args)
 static bool
 setup_stack (void **esp, const char *args) 
 {
+#ifdef VM
+  /* The command line is at most a page, so its strings and argv
+     fit in the top few pages of the stack.  Add those up front,
+     to be loaded as push_arguments() touches them; the stack
+     grows below them on demand. */
+  int i;
+
+  for (i = 1; i <= STACK_ARG_PAGES; i++)
+    if (!page_add_zero ((uint8_t *) PHYS_BASE - i * PGSIZE, true))
+      return false;
+  push_arguments (esp, args);
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -632,9 +718,11 @@ setup_stack (void **esp, const char *args)
         palloc_free_page (kpage);
     }
   return success;
+#endif
 }
 
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -654,3 +742,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
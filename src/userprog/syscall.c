@@ -9,6 +9,12 @@
 #include "threads/synch.h"
 #include "devices/shutdown.h"
 #include "devices/block.h"
+#include "filesys/file.h"
+#include "threads/slab.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 // ---Solutie---
 
@@ -25,9 +31,16 @@ struct file_descriptor
 
 };
 
-static struct lock filesys_lock; 
+/* Cache of struct file_descriptor. */
+static struct kmem_cache *fd_cache;
+
+struct lock filesys_lock;
 // functie ajutatoare
 bool is_valid_ptr(const void *ptr);
+bool is_valid_buffer(const void *buffer, unsigned size);
+#ifdef VM
+bool is_writable_buffer(const void *buffer, unsigned size);
+#endif
 bool is_valid_filename(const void *file);
 
 static void syscall_handler (struct intr_frame *);
@@ -50,11 +63,42 @@ static int write(int fd, const void *buffer, unsigned size);
 static void seek(int fd, unsigned position);
 static unsigned tell(int fd);
 
+static int getrusage(int who, struct rusage *usage);
+
+#ifdef VM
+static int mmap(int fd, void *addr);
+static void munmap(int mapid);
+#endif
+
 void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   lock_init(&filesys_lock);
+  fd_cache = kmem_cache_create("file_descriptor",
+                               sizeof(struct file_descriptor), NULL);
+}
+
+/* Acquires the file system lock, unless the current thread
+   already holds it because a system call it is running faulted.
+   Returns true if the lock was acquired, in which case
+   filesys_leave() must be passed true to release it. */
+bool
+filesys_enter (void)
+{
+  if (lock_held_by_current_thread (&filesys_lock))
+    return false;
+  lock_acquire (&filesys_lock);
+  return true;
+}
+
+/* Releases the file system lock if LOCKED, the value returned by
+   the matching filesys_enter(). */
+void
+filesys_leave (bool locked)
+{
+  if (locked)
+    lock_release (&filesys_lock);
 }
 
 static void
@@ -66,6 +110,12 @@ syscall_handler (struct intr_frame *f)
   uint32_t *argv1 = esp + 2;
   uint32_t *argv2 = esp + 3;
 
+#ifdef VM
+  /* Page faults taken on the user stack during the system call
+     need the user's stack pointer. */
+  thread_current()->user_esp = esp;
+#endif
+
   if (!is_valid_ptr(esp) || !is_valid_ptr(argv0) 
     || !is_valid_ptr(argv1) || !is_valid_ptr(argv2)) 
   {
@@ -118,9 +168,29 @@ syscall_handler (struct intr_frame *f)
   	case SYS_CLOSE:
       close(*argv0);
   		break; 
+  	case SYS_SCHED_DEADLINE:
+      f->eax = thread_set_deadline((int) *argv0, (int) *argv1, (int) *argv2);
+  		break;
+  	case SYS_SCHED_YIELD:
+      thread_deadline_yield();
+  		break;
+  	case SYS_GETRUSAGE:
+      f->eax = getrusage(*argv0, (struct rusage *)*argv1);
+  		break;
+#ifdef VM
+  	case SYS_MMAP:
+      f->eax = mmap(*argv0, (void *)*argv1);
+  		break;
+  	case SYS_MUNMAP:
+      munmap(*argv0);
+  		break;
+#endif
   	default:
   		break; 		  	
   }
+#ifdef VM
+  thread_current()->user_esp = NULL;
+#endif
   // thread_exit ();
   // hex_dump(f->eip, f->eip, 64, true);
 }
@@ -128,18 +198,63 @@ syscall_handler (struct intr_frame *f)
 /* Verifica oricare *ptr sa fie valid --
    1. ptr nu trebuie sa fie un pointer null;
    2. ptr trebuie sa pointeze spre memoria userului;
-   3. ptr nu trebuie sa pointeze spre memoria virtuala nemapata.*/
+   3. ptr nu trebuie sa pointeze spre memoria virtuala nemapata.
+   With VM, a page that has not been touched yet is loaded, and
+   the stack is grown to cover ptr if it looks like a stack access. */
 bool 
 is_valid_ptr(const void *ptr) 
 {
-  if (ptr == NULL 
-    || !is_user_vaddr(ptr) 
-    || pagedir_get_page(thread_current()->pagedir, ptr) == NULL)
+  if (ptr == NULL || !is_user_vaddr(ptr))
     return false;
+  if (pagedir_get_page(thread_current()->pagedir, ptr) != NULL)
+    return true;
+#ifdef VM
+  return (page_load(ptr)
+          || page_grow_stack(ptr, thread_current()->user_esp));
+#else
+  return false;
+#endif
+}
 
+/* Checks that all SIZE bytes at BUFFER are valid, one page at a
+   time, so that no page in the middle is missed. */
+bool
+is_valid_buffer(const void *buffer, unsigned size)
+{
+  const uint8_t *p = buffer;
+  const uint8_t *end = p + size;
+
+  if (size == 0)
+    return true;
+  if (end < p)
+    return false;
+  for (p = pg_round_down(p); p < end; p += PGSIZE)
+    if (!is_valid_ptr(p < (const uint8_t *) buffer ? buffer : p))
+      return false;
   return true;
 }
 
+#ifdef VM
+/* Checks that the process may write all SIZE bytes at BUFFER,
+   which is_valid_buffer() has accepted.  The kernel itself could
+   write to read-only pages, including code shared with other
+   processes. */
+bool
+is_writable_buffer(const void *buffer, unsigned size)
+{
+  const uint8_t *p;
+  const uint8_t *end = (const uint8_t *) buffer + size;
+
+  for (p = pg_round_down(buffer); p < end; p += PGSIZE)
+  {
+    struct page *page = page_lookup(p);
+    if (page == NULL || !page->writable)
+      return false;
+  }
+  return true;
+}
+#endif
+
 /* Verifica fiecare *file sa fie un valid filename. */
 bool 
 is_valid_filename(const void *file)
@@ -182,7 +297,7 @@ close_openfile(int fd)
     { 
       list_remove(e);
       file_close(f->file);
-      free(f);
+      kmem_cache_free(fd_cache, f);
       return;
     }
     else if (f->fd > fd)
@@ -212,11 +327,15 @@ exit(int status)
 
     /* Daca parintele lui inca asteapta dupa acesta,
      transmite parintelui statusul de iesire. */
+  /* With interrupts off, so that the parent cannot exit between
+     the check and the store. */
+  enum intr_level old_level = intr_disable();
   if (cur->parent != NULL)
   {
     cur->parent->child_exit_status = status;
     // printf("parent %s: child_exit(%d)\n", cur->parent->name, cur->parent->child_exit_status);
   }
+  intr_set_level(old_level);
 
   /* Inchide toate fisierele deschise. */
   // mmb -- the key to multi-oom
@@ -225,8 +344,6 @@ exit(int status)
     close(list_entry(list_begin(&cur->open_fd), struct file_descriptor, elem)->fd);  
   }
 
-  /* Inchide fisierul de executie. */
-  file_close(cur->file);
   // ---Solutie---
 
   thread_exit();
@@ -359,7 +476,13 @@ open(const char *file)
   struct file *file_struct = filesys_open(file);
   if (file_struct != NULL) 
   {
-    struct file_descriptor *tmp = malloc(sizeof(struct file_descriptor));    
+    struct file_descriptor *tmp = kmem_cache_alloc(fd_cache);
+    if (tmp == NULL)
+    {
+      file_close(file_struct);
+      lock_release(&filesys_lock);
+      return fd;
+    }
     tmp->fd = assign_fd();
     tmp->file = file_struct;
     // tmp->tid = thread_current()->tid;
@@ -409,8 +532,12 @@ read(int fd, void *buffer, unsigned size)
   // printf("reading\n");
   int status = -1;
 
-  if (!is_valid_ptr(buffer) || !is_valid_ptr(buffer + size - 1)) 
+  if (!is_valid_buffer(buffer, size))
+    exit(-1);
+#ifdef VM
+  if (!is_writable_buffer(buffer, size))
     exit(-1);
+#endif
 
   lock_acquire(&filesys_lock);
   if (fd == STDIN_FILENO) /* Fead from the keyboard.*/
@@ -448,7 +575,7 @@ write(int fd, const void *buffer, unsigned size)
 {
   int status = 0;
 
-  if (buffer == NULL || !is_valid_ptr(buffer) || !is_valid_ptr(buffer + size - 1)) 
+  if (buffer == NULL || !is_valid_buffer(buffer, size))
     exit(-1);
 
   lock_acquire(&filesys_lock);
@@ -502,3 +629,71 @@ tell(int fd)
 
   return status;
 }
+
+/* Copies the resource usage of the current process, or of its
+   exited children if WHO is RUSAGE_CHILDREN, to *USAGE.
+   Returns 0 if successful, -1 if WHO is invalid. */
+static int
+getrusage(int who, struct rusage *usage)
+{
+  struct thread *cur = thread_current();
+
+  if (!is_valid_buffer(usage, sizeof *usage))
+    exit(-1);
+#ifdef VM
+  if (!is_writable_buffer(usage, sizeof *usage))
+    exit(-1);
+#endif
+
+  if (who == RUSAGE_SELF)
+    *usage = cur->rusage;
+  else if (who == RUSAGE_CHILDREN)
+    *usage = cur->child_rusage;
+  else
+    return -1;
+  return 0;
+}
+
+#ifdef VM
+/* Maps the file open as fd into memory at addr, which must be
+   page-aligned.  The mapping reads and writes the file through
+   its own reopened copy, so it outlives close(fd).
+   Returns the mapping id, or -1 if the file cannot be mapped. */
+static int
+mmap(int fd, void *addr)
+{
+  struct file *file = NULL;
+  off_t length = 0;
+  int mapid;
+
+  lock_acquire(&filesys_lock);
+  struct file_descriptor *file_descriptor = get_openfile(fd);
+  if (file_descriptor != NULL)
+  {
+    file = file_reopen(file_descriptor->file);
+    if (file != NULL)
+      length = file_length(file);
+  }
+  lock_release(&filesys_lock);
+
+  if (file == NULL)
+    return MAP_FAILED;
+
+  mapid = mmap_map(file, length, addr);
+  if (mapid == MAP_FAILED)
+  {
+    lock_acquire(&filesys_lock);
+    file_close(file);
+    lock_release(&filesys_lock);
+  }
+  return mapid;
+}
+
+/* Unmaps the mapping mapid, writing the pages that were changed
+   back to the file. */
+static void
+munmap(int mapid)
+{
+  mmap_unmap(mapid);
+}
+#endif
@@ -1,7 +1,15 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* Serializes file system access by user processes. */
+extern struct lock filesys_lock;
+
 void syscall_init (void);
+bool filesys_enter (void);
+void filesys_leave (bool);
 void exit(int status);
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,230 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/share.h"
+
+/* Number of victims frame_alloc() tries to evict before giving
+   up, if their pages cannot be written out. */
+#define EVICT_TRIES 4
+
+/* Frame table: every frame holding a user page, in clock order.
+   FRAME_LOCK protects the list and the clock hand.  It is never
+   held across disk I/O: a victim is taken out of the table with
+   its page locked before being written out. */
+static struct list frames;
+static struct list_elem *hand;
+static struct lock frame_lock;
+
+static struct frame *add_frame (struct page *, struct share *);
+static struct frame *evict (void);
+static struct frame *choose_victim (void);
+static bool lock_victim (struct frame *);
+static void unlock_victim (struct frame *);
+static bool test_accessed (struct frame *);
+static void remove_frame (struct frame *);
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frames);
+  lock_init (&frame_lock);
+}
+
+/* Returns a frame of the user pool for PAGE, whose lock the
+   caller must hold, evicting another page if the pool is empty.
+   Returns a null pointer if no frame can be found. */
+struct frame *
+frame_alloc (struct page *page)
+{
+  ASSERT (lock_held_by_current_thread (&page->lock));
+
+  return add_frame (page, NULL);
+}
+
+/* Returns a frame for shared page SHARE, which the caller must
+   have locked, as frame_alloc() does for an unshared page. */
+struct frame *
+frame_alloc_shared (struct share *share)
+{
+  return add_frame (NULL, share);
+}
+
+/* Removes F from the frame table and frees it.  Its page must
+   already be unmapped. */
+void
+frame_free (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  remove_frame (f);
+  lock_release (&frame_lock);
+
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Returns a frame for PAGE or SHARE, whichever is non-null,
+   evicting another page if the pool is empty.  Returns a null
+   pointer if no frame can be found. */
+static struct frame *
+add_frame (struct page *page, struct share *share)
+{
+  struct frame *f;
+  void *kpage;
+
+  kpage = palloc_get_page (PAL_USER);
+  if (kpage != NULL)
+    {
+      f = malloc (sizeof *f);
+      if (f == NULL)
+        {
+          palloc_free_page (kpage);
+          return NULL;
+        }
+      f->kpage = kpage;
+    }
+  else
+    {
+      f = evict ();
+      if (f == NULL)
+        return NULL;
+    }
+
+  f->page = page;
+  f->share = share;
+  lock_acquire (&frame_lock);
+  list_push_back (&frames, &f->elem);
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Evicts a page and returns its frame, taken out of the frame
+   table, or returns a null pointer if no page can be evicted. */
+static struct frame *
+evict (void)
+{
+  int i;
+
+  for (i = 0; i < EVICT_TRIES; i++)
+    {
+      struct frame *f = choose_victim ();
+      struct page *p;
+      bool evicted;
+
+      if (f == NULL)
+        return NULL;
+      if (f->share != NULL)
+        {
+          /* Shared pages are read-only, so always evictable. */
+          share_evict (f->share);
+          share_unlock (f->share);
+          return f;
+        }
+      p = f->page;
+      evicted = page_evict (p);
+      if (!evicted)
+        {
+          /* Its page is still in it.  Put it back before unlocking
+             the page, which may be freed as soon as we do. */
+          lock_acquire (&frame_lock);
+          list_push_back (&frames, &f->elem);
+          lock_release (&frame_lock);
+        }
+      lock_release (&p->lock);
+      if (evicted)
+        return f;
+    }
+  return NULL;
+}
+
+/* Runs the second-chance clock over the frame table to find a
+   frame whose page has not been accessed since the hand last
+   passed it, by any process sharing it, clearing accessed bits
+   along the way.  Frames whose pages are locked, because they
+   are being loaded, evicted or freed, are skipped.  Returns the
+   frame, taken out of the table with its page locked, or a null
+   pointer if two trips around the clock found nothing. */
+static struct frame *
+choose_victim (void)
+{
+  struct frame *victim = NULL;
+  size_t n;
+
+  lock_acquire (&frame_lock);
+  for (n = 2 * list_size (&frames); n > 0 && victim == NULL; n--)
+    {
+      struct frame *f;
+
+      if (hand == NULL || hand == list_end (&frames))
+        hand = list_begin (&frames);
+      f = list_entry (hand, struct frame, elem);
+      hand = list_next (hand);
+
+      if (!lock_victim (f))
+        continue;
+      if (test_accessed (f))
+        {
+          unlock_victim (f);
+          continue;
+        }
+      remove_frame (f);
+      victim = f;
+    }
+  lock_release (&frame_lock);
+  return victim;
+}
+
+/* Tries to lock the page in F, without waiting.  Returns true if
+   successful. */
+static bool
+lock_victim (struct frame *f)
+{
+  if (f->share != NULL)
+    return share_try_lock (f->share);
+  return lock_try_acquire (&f->page->lock);
+}
+
+/* Unlocks the page in F. */
+static void
+unlock_victim (struct frame *f)
+{
+  if (f->share != NULL)
+    share_unlock (f->share);
+  else
+    lock_release (&f->page->lock);
+}
+
+/* Returns true if the page in F has been accessed since the last
+   call, and clears its accessed bit. */
+static bool
+test_accessed (struct frame *f)
+{
+  struct page *p = f->page;
+  uint32_t *pd;
+
+  if (f->share != NULL)
+    return share_test_accessed (f->share);
+
+  pd = p->owner->pagedir;
+  if (!pagedir_is_accessed (pd, p->upage))
+    return false;
+  pagedir_set_accessed (pd, p->upage, false);
+  return true;
+}
+
+/* Removes F from the frame table, moving the clock hand past it
+   if necessary.  FRAME_LOCK must be held. */
+static void
+remove_frame (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (hand == &f->elem)
+    hand = list_next (hand);
+  list_remove (&f->elem);
+}
@@ -0,0 +1,24 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+
+struct page;
+struct share;
+
+/* A frame of the user pool holding a page of some process, or a
+   page shared by several processes. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address. */
+    struct page *page;          /* Page it holds, or null if shared. */
+    struct share *share;        /* Shared page it holds, or null. */
+    struct list_elem elem;      /* Element in the frame table. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *);
+struct frame *frame_alloc_shared (struct share *);
+void frame_free (struct frame *);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,125 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* A file mapped into a process's address space.  Its pages are
+   read from the file the first time they are touched and written
+   back, if dirty, when evicted or unmapped. */
+struct mapping
+  {
+    int id;                     /* Mapping identifier. */
+    struct file *file;          /* File mapped, owned by the mapping. */
+    uint8_t *base;              /* First page. */
+    size_t page_cnt;            /* Number of pages. */
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+  };
+
+static void unmap (struct mapping *);
+
+/* Maps the LENGTH bytes of FILE into the current process's
+   address space starting at page-aligned user address ADDR.  The
+   mapping takes over FILE and closes it when it goes away, so the
+   caller should pass a reopened file.  Returns the new mapping's
+   identifier, or MAP_FAILED if FILE is empty, ADDR is not a
+   page-aligned user address, the range overlaps pages already in
+   use or memory is short.  On failure, FILE is left open. */
+int
+mmap_map (struct file *file, off_t length, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  size_t page_cnt;
+  size_t i;
+
+  if (length <= 0 || addr == NULL || pg_ofs (addr) != 0)
+    return MAP_FAILED;
+  page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  if ((uintptr_t) addr + page_cnt * PGSIZE > (uintptr_t) PHYS_BASE
+      || (uintptr_t) addr + page_cnt * PGSIZE < (uintptr_t) addr)
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+  m->file = file;
+  m->base = addr;
+  m->page_cnt = 0;
+  for (i = 0; i < page_cnt; i++)
+    {
+      off_t ofs = i * PGSIZE;
+      size_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+      if (!page_add_mmap (m->base + ofs, file, ofs, read_bytes))
+        {
+          /* Take back the pages added so far.  None has been
+             touched, so nothing is written to FILE. */
+          while (i-- > 0)
+            page_remove (m->base + i * PGSIZE);
+          free (m);
+          return MAP_FAILED;
+        }
+    }
+  m->page_cnt = page_cnt;
+  m->id = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->id;
+}
+
+/* Unmaps the current process's mapping MAPID, writing its dirty
+   pages back to the file.  Returns true if successful, false if
+   there is no such mapping. */
+bool
+mmap_unmap (int mapid)
+{
+  struct list *mappings = &thread_current ()->mappings;
+  struct list_elem *e;
+
+  for (e = list_begin (mappings); e != list_end (mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == mapid)
+        {
+          unmap (m);
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Unmaps all of the current process's mappings.  Must be called
+   before its supplemental page table is destroyed, while the
+   mapped files are still open. */
+void
+mmap_unmap_all (void)
+{
+  struct list *mappings = &thread_current ()->mappings;
+
+  while (!list_empty (mappings))
+    unmap (list_entry (list_front (mappings), struct mapping, elem));
+}
+
+/* Writes back and removes the pages of mapping M, closes its
+   file and frees it. */
+static void
+unmap (struct mapping *m)
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (m->base + i * PGSIZE);
+  list_remove (&m->elem);
+
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+}
@@ -0,0 +1,16 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct file;
+
+/* Value returned by mmap_map() on failure. */
+#define MAP_FAILED (-1)
+
+int mmap_map (struct file *, off_t length, void *addr);
+bool mmap_unmap (int mapid);
+void mmap_unmap_all (void);
+
+#endif /* vm/mmap.h */
@@ -0,0 +1,395 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+
+/* Default stack size limit. */
+#define STACK_LIMIT_DEFAULT (8 * 1024 * 1024)
+
+/* Largest size to which a process's stack may grow, in bytes. */
+size_t page_stack_limit = STACK_LIMIT_DEFAULT;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_free;
+static struct page *page_add (void *upage, bool writable);
+static bool page_in (struct page *);
+static void page_discard (struct page *);
+
+/* Initializes PAGES as an empty supplemental page table.
+   Returns true if successful, false if memory is short. */
+bool
+page_table_init (struct hash *pages)
+{
+  return hash_init (pages, page_hash, page_less, NULL);
+}
+
+/* Frees the supplemental page table PAGES, if it was ever
+   initialized, along with the frames and swap slots of its
+   pages.  Must be called before the owner's page directory is
+   destroyed. */
+void
+page_table_destroy (struct hash *pages)
+{
+  if (page_table_active (pages))
+    hash_destroy (pages, page_free);
+}
+
+/* Returns true if page_table_init() has been run on PAGES.
+   struct thread starts out zeroed, so the table of a kernel
+   thread, or of a process that has not started loading, has no
+   buckets. */
+bool
+page_table_active (const struct hash *pages)
+{
+  return pages->buckets != NULL;
+}
+
+/* Returns the current process's page containing user virtual
+   address ADDR, or a null pointer if there is none. */
+struct page *
+page_lookup (const void *addr)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (addr);
+  e = hash_find (&thread_current ()->pages, &p.elem);
+  return e != NULL ? hash_entry (e, struct page, elem) : NULL;
+}
+
+/* Adds a page at UPAGE to the current process whose first
+   READ_BYTES bytes are read from FILE starting at offset OFS and
+   whose remaining bytes are zeroed.  FILE must stay open as long
+   as the page exists.  A read-only page shares its frame with
+   those of other processes at the same offset in the same file.
+   Returns true if successful, false if UPAGE is already in use
+   or memory is short. */
+bool
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = page_add (upage, writable);
+  if (p == NULL)
+    return false;
+  p->source = PAGE_FILE;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  if (!writable && !share_add (p))
+    {
+      hash_delete (&p->owner->pages, &p->elem);
+      free (p);
+      return false;
+    }
+  return true;
+}
+
+/* Adds a zero-filled page at UPAGE to the current process.
+   Returns true if successful, false if UPAGE is already in use
+   or memory is short. */
+bool
+page_add_zero (void *upage, bool writable)
+{
+  struct page *p = page_add (upage, writable);
+  if (p == NULL)
+    return false;
+  p->source = PAGE_ZERO;
+  return true;
+}
+
+/* Adds a page at UPAGE to the current process that maps the
+   READ_BYTES bytes of FILE starting at offset OFS, followed by
+   zeros.  Unlike a page added by page_add_file(), the page is
+   always writable and changes to it are written back to FILE.
+   FILE must stay open as long as the page exists.  Returns true
+   if successful, false if UPAGE is already in use or memory is
+   short. */
+bool
+page_add_mmap (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = page_add (upage, true);
+  if (p == NULL)
+    return false;
+  p->source = PAGE_MMAP;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  return true;
+}
+
+/* Removes the current process's page at UPAGE, if there is one,
+   writing it back to its file first if it is a dirty page of a
+   memory-mapped file. */
+void
+page_remove (void *upage)
+{
+  struct page *p = page_lookup (upage);
+
+  if (p == NULL)
+    return;
+  page_discard (p);
+  hash_delete (&p->owner->pages, &p->elem);
+  free (p);
+}
+
+/* Brings the current process's page containing ADDR into memory
+   and maps it, if it is not there already.  Returns true if
+   successful, false if ADDR is not in any page or the page
+   cannot be loaded. */
+bool
+page_load (const void *addr)
+{
+  struct page *p = page_lookup (addr);
+  bool success;
+
+  if (p == NULL)
+    return false;
+
+  lock_acquire (&p->lock);
+  success = p->frame != NULL || page_in (p);
+  lock_release (&p->lock);
+  return success;
+}
+
+/* Evicts page P, which must be locked and whose frame must
+   already be out of the frame table.  Unmaps P, then writes it to
+   swap if it cannot be read or zeroed again.  Returns true if
+   successful.  Otherwise, that is, if swap is full, leaves P
+   mapped in its frame and returns false. */
+bool
+page_evict (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+  bool dirty;
+
+  ASSERT (lock_held_by_current_thread (&p->lock));
+  ASSERT (p->frame != NULL);
+
+  /* Unmap the page first, so that the owner cannot change it
+     while we write it out.  Clearing a mapping keeps its dirty
+     bit. */
+  pagedir_clear_page (pd, p->upage);
+  dirty = pagedir_is_dirty (pd, p->upage);
+
+  if (p->source == PAGE_MMAP)
+    {
+      /* Write back to the file.  Whoever holds the file system
+         lock may be waiting for this very page, so do not wait
+         for the lock: let the caller pick another victim. */
+      if (dirty)
+        {
+          bool locked = lock_held_by_current_thread (&filesys_lock);
+          if (!locked && !lock_try_acquire (&filesys_lock))
+            {
+              pagedir_set_page (pd, p->upage, p->frame->kpage, true);
+              pagedir_set_dirty (pd, p->upage, true);
+              return false;
+            }
+          file_write_at (p->file, p->frame->kpage, p->read_bytes, p->ofs);
+          if (!locked)
+            lock_release (&filesys_lock);
+        }
+    }
+  else if (dirty || p->source == PAGE_SWAP)
+    {
+      size_t slot = swap_out (p->frame->kpage);
+      if (slot == SWAP_ERROR)
+        {
+          pagedir_set_page (pd, p->upage, p->frame->kpage, p->writable);
+          pagedir_set_dirty (pd, p->upage, dirty);
+          return false;
+        }
+      p->source = PAGE_SWAP;
+      p->swap_slot = slot;
+    }
+
+  p->frame = NULL;
+  return true;
+}
+
+/* If ADDR looks like an access to the stack of the current
+   process, whose stack pointer is ESP, adds a zeroed stack page
+   containing ADDR and loads it.  An access looks like one to the
+   stack if it is within page_stack_limit bytes of the top of user
+   memory and no more than 32 bytes below ESP, which PUSHA may
+   touch before it updates the stack pointer.  Returns true if
+   successful, false otherwise. */
+bool
+page_grow_stack (const void *addr, const void *esp)
+{
+  uintptr_t a = (uintptr_t) addr;
+  void *upage = pg_round_down (addr);
+
+  if (!is_user_vaddr (addr)
+      || a + 32 < (uintptr_t) esp
+      || a < (uintptr_t) PHYS_BASE - page_stack_limit)
+    return false;
+  return page_add_zero (upage, true) && page_load (upage);
+}
+
+/* Loads locked page P into a new frame and maps it.  Returns
+   true if successful, false otherwise. */
+static bool
+page_in (struct page *p)
+{
+  struct frame *f;
+  uint8_t *kpage;
+
+  ASSERT (lock_held_by_current_thread (&p->lock));
+
+  if (p->share != NULL)
+    return share_load (p);
+
+  f = frame_alloc (p);
+  if (f == NULL)
+    return false;
+  kpage = f->kpage;
+
+  switch (p->source)
+    {
+    case PAGE_FILE:
+    case PAGE_MMAP:
+      {
+        bool locked = filesys_enter ();
+        off_t bytes_read = file_read_at (p->file, kpage, p->read_bytes,
+                                         p->ofs);
+        filesys_leave (locked);
+        if (bytes_read != (off_t) p->read_bytes)
+          {
+            frame_free (f);
+            return false;
+          }
+      }
+      memset (kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+      break;
+
+    case PAGE_ZERO:
+      memset (kpage, 0, PGSIZE);
+      break;
+
+    case PAGE_SWAP:
+      swap_in (p->swap_slot, kpage);
+      p->swap_slot = SWAP_ERROR;
+      break;
+
+    default:
+      NOT_REACHED ();
+    }
+
+  if (!pagedir_set_page (p->owner->pagedir, p->upage, kpage, p->writable))
+    {
+      frame_free (f);
+      return false;
+    }
+  p->frame = f;
+  return true;
+}
+
+/* Adds a page at UPAGE to the current process and returns it, or
+   returns a null pointer if UPAGE is already in use or memory is
+   short. */
+static struct page *
+page_add (void *upage, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->owner = thread_current ();
+  p->writable = writable;
+  lock_init (&p->lock);
+  p->frame = NULL;
+  p->file = NULL;
+  p->ofs = 0;
+  p->read_bytes = 0;
+  p->swap_slot = SWAP_ERROR;
+  p->share = NULL;
+  if (hash_insert (&p->owner->pages, &p->elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Returns a hash value for page P_. */
+static unsigned
+page_hash (const struct hash_elem *p_, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (p_, struct page, elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, elem);
+  const struct page *b = hash_entry (b_, struct page, elem);
+  return a->upage < b->upage;
+}
+
+/* Frees page P_. */
+static void
+page_free (struct hash_elem *p_, void *aux UNUSED)
+{
+  struct page *p = hash_entry (p_, struct page, elem);
+
+  page_discard (p);
+  free (p);
+}
+
+/* Unmaps page P and releases its frame or swap slot, first
+   writing it back if it is a dirty page of a memory-mapped file.
+   Waits for any eviction of P in progress to finish. */
+static void
+page_discard (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+
+  lock_acquire (&p->lock);
+  if (p->share != NULL)
+    share_remove (p);
+  else if (p->frame != NULL)
+    {
+      pagedir_clear_page (pd, p->upage);
+      if (p->source == PAGE_MMAP && pagedir_is_dirty (pd, p->upage))
+        {
+          bool locked = filesys_enter ();
+          file_write_at (p->file, p->frame->kpage, p->read_bytes, p->ofs);
+          filesys_leave (locked);
+        }
+      frame_free (p->frame);
+      p->frame = NULL;
+    }
+  else if (p->swap_slot != SWAP_ERROR)
+    {
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_ERROR;
+    }
+  lock_release (&p->lock);
+}
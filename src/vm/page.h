@@ -0,0 +1,79 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+/* Where a page's contents come from when it is not in memory. */
+enum page_source
+  {
+    PAGE_FILE,                  /* Read from a file, zero the rest. */
+    PAGE_ZERO,                  /* All zeros. */
+    PAGE_SWAP,                  /* Anonymous: kept in swap when evicted. */
+    PAGE_MMAP                   /* Mapped file: written back when evicted. */
+  };
+
+/* A page of a process's virtual address space, as recorded in its
+   supplemental page table.  Pages are loaded into a frame the
+   first time they are touched, and may be evicted from it again
+   to make room for others.
+
+   A page that has been written to becomes anonymous once evicted:
+   it goes to swap, and its source becomes PAGE_SWAP for good.
+   Pages of a memory-mapped file are the exception: they are
+   written back to the file instead, and read from it again.
+
+   Read-only pages of an executable never change, so processes
+   running the same one share them: see vm/share.c. */
+struct page
+  {
+    void *upage;                /* User virtual address. */
+    struct thread *owner;       /* Process it belongs to. */
+    bool writable;              /* May the process write it? */
+
+    /* LOCK protects the members below.  It is held while the
+       page is loaded, evicted or freed, and keeps the frame table
+       from choosing it as a victim meanwhile. */
+    struct lock lock;
+    struct frame *frame;        /* Frame holding it, or null. */
+    enum page_source source;    /* Where the contents come from. */
+
+    /* PAGE_FILE and PAGE_MMAP. */
+    struct file *file;          /* File to read. */
+    off_t ofs;                  /* Offset in FILE. */
+    size_t read_bytes;          /* Bytes to read; the rest are zeroed. */
+
+    /* PAGE_SWAP. */
+    size_t swap_slot;           /* Slot while evicted, else SWAP_ERROR. */
+
+    /* Read-only PAGE_FILE pages, whose frame is shared instead. */
+    struct share *share;        /* Shared page, or null. */
+    struct list_elem share_elem; /* Element in share's page list. */
+
+    struct hash_elem elem;      /* Element in thread's `pages'. */
+  };
+
+/* Largest size to which a process's stack may grow, in bytes.
+   Controlled by kernel command-line option "-stack". */
+extern size_t page_stack_limit;
+
+bool page_table_init (struct hash *);
+void page_table_destroy (struct hash *);
+bool page_table_active (const struct hash *);
+
+struct page *page_lookup (const void *addr);
+bool page_add_file (void *upage, struct file *, off_t ofs,
+                    size_t read_bytes, bool writable);
+bool page_add_zero (void *upage, bool writable);
+bool page_add_mmap (void *upage, struct file *, off_t ofs,
+                    size_t read_bytes);
+void page_remove (void *upage);
+bool page_load (const void *addr);
+bool page_evict (struct page *);
+bool page_grow_stack (const void *addr, const void *esp);
+
+#endif /* vm/page.h */
@@ -0,0 +1,253 @@
+#include "vm/share.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* A read-only page of an executable, shared by every process
+   that maps the same part of the same file.  It is read from the
+   file once, into one frame, which each sharer maps read-only.
+
+   The file is identified by its inode.  The inode stays open as
+   long as there are sharers, since each of them keeps its
+   executable open until after its pages are freed. */
+struct share
+  {
+    /* Key. */
+    struct inode *inode;        /* File. */
+    off_t ofs;                  /* Offset in file. */
+    size_t read_bytes;          /* Bytes read; the rest are zeroed. */
+
+    /* SHARE_LOCK protects these members. */
+    struct hash_elem elem;      /* Element in `shares'. */
+    struct list pages;          /* Sharers' pages. */
+
+    /* LOCK protects FRAME.  It is held while the page is loaded,
+       evicted or freed, as for an unshared page. */
+    struct lock lock;
+    struct frame *frame;        /* Frame holding it, or null. */
+  };
+
+/* All shared pages.  SHARE_LOCK is never held while acquiring
+   any other lock. */
+static struct hash shares;
+static struct lock share_lock;
+
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Initializes the table of shared pages. */
+void
+share_init (void)
+{
+  if (!hash_init (&shares, share_hash, share_less, NULL))
+    PANIC ("share: hash table creation failed");
+  lock_init (&share_lock);
+}
+
+/* Makes read-only page P, which must have a file to read from,
+   share its contents with the other pages of the same part of
+   the same file.  Returns true if successful, false if memory is
+   short. */
+bool
+share_add (struct page *p)
+{
+  struct share key;
+  struct share *s;
+  struct hash_elem *e;
+
+  ASSERT (!p->writable && p->file != NULL);
+
+  key.inode = file_get_inode (p->file);
+  key.ofs = p->ofs;
+  key.read_bytes = p->read_bytes;
+
+  lock_acquire (&share_lock);
+  e = hash_find (&shares, &key.elem);
+  if (e != NULL)
+    s = hash_entry (e, struct share, elem);
+  else
+    {
+      s = malloc (sizeof *s);
+      if (s == NULL)
+        {
+          lock_release (&share_lock);
+          return false;
+        }
+      *s = key;
+      list_init (&s->pages);
+      lock_init (&s->lock);
+      s->frame = NULL;
+      hash_insert (&shares, &s->elem);
+    }
+  list_push_back (&s->pages, &p->share_elem);
+  lock_release (&share_lock);
+
+  p->share = s;
+  return true;
+}
+
+/* Maps shared page P, which must be locked, reading it from its
+   file first if no sharer has it in memory.  Returns true if
+   successful, false otherwise. */
+bool
+share_load (struct page *p)
+{
+  struct share *s = p->share;
+  bool success;
+
+  ASSERT (lock_held_by_current_thread (&p->lock));
+
+  lock_acquire (&s->lock);
+  if (s->frame == NULL)
+    {
+      struct frame *f = frame_alloc_shared (s);
+      bool locked;
+      off_t bytes_read;
+
+      if (f == NULL)
+        {
+          lock_release (&s->lock);
+          return false;
+        }
+      locked = filesys_enter ();
+      bytes_read = file_read_at (p->file, f->kpage, s->read_bytes, s->ofs);
+      filesys_leave (locked);
+      if (bytes_read != (off_t) s->read_bytes)
+        {
+          frame_free (f);
+          lock_release (&s->lock);
+          return false;
+        }
+      memset ((uint8_t *) f->kpage + s->read_bytes, 0,
+              PGSIZE - s->read_bytes);
+      s->frame = f;
+    }
+  success = pagedir_set_page (p->owner->pagedir, p->upage,
+                              s->frame->kpage, false);
+  lock_release (&s->lock);
+  return success;
+}
+
+/* Unmaps shared page P, which must be locked, and stops it from
+   sharing.  The last sharer to go frees the frame. */
+void
+share_remove (struct page *p)
+{
+  struct share *s = p->share;
+  bool last;
+
+  ASSERT (lock_held_by_current_thread (&p->lock));
+
+  lock_acquire (&s->lock);
+  pagedir_clear_page (p->owner->pagedir, p->upage);
+
+  lock_acquire (&share_lock);
+  list_remove (&p->share_elem);
+  last = list_empty (&s->pages);
+  if (last)
+    hash_delete (&shares, &s->elem);
+  lock_release (&share_lock);
+
+  if (last && s->frame != NULL)
+    frame_free (s->frame);
+  lock_release (&s->lock);
+  if (last)
+    free (s);
+  p->share = NULL;
+}
+
+/* Tries to lock S for eviction, without waiting.  Returns true
+   if successful. */
+bool
+share_try_lock (struct share *s)
+{
+  return lock_try_acquire (&s->lock);
+}
+
+/* Unlocks S. */
+void
+share_unlock (struct share *s)
+{
+  lock_release (&s->lock);
+}
+
+/* Returns true if any sharer has accessed S since the last call,
+   and clears their accessed bits. */
+bool
+share_test_accessed (struct share *s)
+{
+  bool accessed = false;
+  struct list_elem *e;
+
+  lock_acquire (&share_lock);
+  for (e = list_begin (&s->pages); e != list_end (&s->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, share_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          pagedir_set_accessed (pd, p->upage, false);
+          accessed = true;
+        }
+    }
+  lock_release (&share_lock);
+  return accessed;
+}
+
+/* Evicts S, which must be locked and whose frame must already be
+   out of the frame table, by unmapping it from every sharer.  It
+   is read-only, so there is nothing to write out. */
+void
+share_evict (struct share *s)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&s->lock));
+  ASSERT (s->frame != NULL);
+
+  lock_acquire (&share_lock);
+  for (e = list_begin (&s->pages); e != list_end (&s->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, share_elem);
+      pagedir_clear_page (p->owner->pagedir, p->upage);
+    }
+  lock_release (&share_lock);
+  s->frame = NULL;
+}
+
+/* Returns a hash value for shared page S_. */
+static unsigned
+share_hash (const struct hash_elem *s_, void *aux UNUSED)
+{
+  const struct share *s = hash_entry (s_, struct share, elem);
+  return (hash_bytes (&s->inode, sizeof s->inode)
+          ^ hash_int (s->ofs) ^ hash_int (s->read_bytes));
+}
+
+/* Returns true if shared page A precedes shared page B. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct share *a = hash_entry (a_, struct share, elem);
+  const struct share *b = hash_entry (b_, struct share, elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  return a->read_bytes < b->read_bytes;
+}
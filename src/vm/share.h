@@ -0,0 +1,20 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <stdbool.h>
+
+struct page;
+struct share;
+
+void share_init (void);
+bool share_add (struct page *);
+bool share_load (struct page *);
+void share_remove (struct page *);
+
+/* Used by the frame table. */
+bool share_try_lock (struct share *);
+void share_unlock (struct share *);
+bool share_test_accessed (struct share *);
+void share_evict (struct share *);
+
+#endif /* vm/share.h */